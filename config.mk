@@ -30,6 +30,14 @@ log_accel_gesture_fifo=false
 #sparkle=true
 #show_sec_always=true
 #self_test_accel=true
+#busy_wait_ticks=true
+#fixed_tick=true
+#led_dma=true
+#led_bcm=true
+#charge_limit=24
+#auto_brightness=false
+#profile=true
+#wake_trace=true
 
 ifdef debug_accel_isr
     debug_ax_isr=true
@@ -164,6 +172,11 @@ endif
 #endif
 #endif
 
+# Frame sequences for anim_frames(), encoded into FRAMES_SRC (and its
+# header) by scripts/frames2anim.py whenever they change
+FRAME_SEQUENCES = $(wildcard graphics/frames/*.txt graphics/frames/*.gif)
+FRAMES_SRC = src/frames.c
+
 #make bin output directory if it doesnt exist
 BUILD_DIR=bin
 $(shell mkdir $(BUILD_DIR) 2>/dev/null)
@@ -177,7 +190,12 @@ CSRCS += \
     src/anim.c						       	\
     src/control.c					       	\
     src/display.c					       	\
+    src/hist.c						       	\
+    $(FRAMES_SRC)					       	\
     src/leds.c						       	\
+    src/pool.c						       	\
+    src/prof.c						       	\
+    src/trace.c						       	\
     src/utils.c						       	\
     src/asf/common/utils/interrupt/interrupt_sam_nvic.c        	\
     src/asf/common2/services/delay/sam0/systick_counter.c      	\
@@ -381,3 +399,27 @@ endif
 ifdef skip_wait_for_down
 CPPFLAGS+= -D SKIP_WAIT_FOR_DOWN=$(skip_wait_for_down)
 endif
+ifdef busy_wait_ticks
+CPPFLAGS+= -D IDLE_BETWEEN_TICKS=false
+endif
+ifdef fixed_tick
+CPPFLAGS+= -D VARIABLE_TICK=false
+endif
+ifdef led_dma
+CPPFLAGS+= -D LED_DMA_SCAN=$(led_dma)
+endif
+ifdef led_bcm
+CPPFLAGS+= -D LED_BCM=$(led_bcm)
+endif
+ifdef charge_limit
+CPPFLAGS+= -D LED_CHARGE_LIMIT=$(charge_limit)
+endif
+ifdef auto_brightness
+CPPFLAGS+= -D AUTO_BRIGHTNESS=$(auto_brightness)
+endif
+ifdef profile
+CPPFLAGS+= -D PROFILE=$(profile)
+endif
+ifdef wake_trace
+CPPFLAGS+= -D WAKE_TRACE=$(wake_trace)
+endif
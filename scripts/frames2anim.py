@@ -0,0 +1,210 @@
+#!/usr/bin/python
+""" encode led frame sequences for anim_frames()
+
+    usage: frames2anim.py [-r radius] -o frames.c sequence...
+
+    Each sequence becomes a const uint8_t array (placed in flash) named
+    FRAMES_<NAME> after its file, declared in a header next to the .c
+    file.  A sequence is either
+
+      - an animated GIF (e.g. one made with gif2anim/anim2gif), sampled
+        at the 60 leds around a ring centred in the image.  The ring's
+        radius is a fraction (-r, default 0.45) of the image's smaller
+        side.  Brightness becomes led intensity and each frame keeps its
+        GIF duration
+
+      - a text file with a frame per line: its duration in ms, then
+        either 60 intensities or any number of led=intensity or
+        first-last=intensity settings (other leds off).  # starts a
+        comment
+
+    Intensities are fine levels, 0 (off) to 255.  See anim.h and
+    display.h for the encoding
+"""
+
+from __future__ import print_function
+from __future__ import division
+from __future__ import absolute_import
+from __future__ import unicode_literals
+
+import argparse
+import math
+import os
+import re
+import sys
+
+LED_COUNT = 60
+
+FRAME_OFF = 0x00
+FRAME_FILL = 0x40
+FRAME_COPY = 0x80
+FRAME_END = 0x00
+FRAME_RUN_MAX = 0x3f
+
+# a fill run costs 2 bytes, so shorter repeats are copied
+FILL_MIN = 3
+
+
+def parse_text( path ):
+    """ frames of a text sequence as (ms, levels) """
+    frames = []
+    with open( path ) as f:
+        for num, line in enumerate( f, 1 ):
+            fields = line.split( '#' )[0].split()
+            if not fields:
+                continue
+
+            where = "{}:{}".format( path, num )
+            ms = int( fields[0], 0 )
+            levels = [ 0 ] * LED_COUNT
+
+            if len( fields ) == LED_COUNT + 1 and '=' not in line:
+                levels = [ int( v, 0 ) for v in fields[1:] ]
+            else:
+                for field in fields[1:]:
+                    m = re.match( r'^(\d+)(?:-(\d+))?=(\w+)$', field )
+                    if not m:
+                        sys.exit( "{}: bad setting '{}'".format( where, field ) )
+                    first = int( m.group(1) )
+                    last = int( m.group(2) ) if m.group(2) else first
+                    if last >= LED_COUNT or first > last:
+                        sys.exit( "{}: bad leds '{}'".format( where, field ) )
+                    for led in range( first, last + 1 ):
+                        levels[led] = int( m.group(3), 0 )
+
+            frames.append( ( ms, levels ) )
+    return frames
+
+
+def parse_gif( path, radius ):
+    """ frames of an animated GIF, sampled around a ring, as (ms, levels) """
+    try:
+        from PIL import Image, ImageSequence
+    except ImportError:
+        import Image, ImageSequence
+
+    img = Image.open( path )
+    frames = []
+    for frame in ImageSequence.Iterator( img ):
+        gray = frame.convert( 'L' )
+        w, h = gray.size
+        r = radius * min( w, h )
+
+        levels = []
+        for led in range( LED_COUNT ):
+            # led 0 at 12 o'clock, then clockwise
+            angle = 2 * math.pi * led / LED_COUNT
+            x = int( round( w / 2 + r * math.sin( angle ) ) )
+            y = int( round( h / 2 - r * math.cos( angle ) ) )
+            levels.append( gray.getpixel( ( min( x, w - 1 ), min( y, h - 1 ) ) ) )
+
+        frames.append( ( frame.info.get( 'duration', 100 ), levels ) )
+    return frames
+
+
+def encode_frame( levels ):
+    """ run length encode the leds of a frame """
+    out = []
+    led = 0
+
+    # trailing leds that are off need no runs
+    end = LED_COUNT
+    while end and not levels[end - 1]:
+        end -= 1
+
+    while led < end:
+        level = levels[led]
+        n = 1
+        while led + n < end and levels[led + n] == level and n < FRAME_RUN_MAX:
+            n += 1
+
+        if not level:
+            out.append( FRAME_OFF | n )
+        elif n >= FILL_MIN:
+            out += [ FRAME_FILL | n, level ]
+        else:
+            # copy up to the next run worth filling (or off)
+            n = 0
+            while led + n < end and n < FRAME_RUN_MAX:
+                run = 1
+                while (led + n + run < end and run < FILL_MIN and
+                        levels[led + n + run] == levels[led + n]):
+                    run += 1
+                if not levels[led + n] or run >= FILL_MIN:
+                    break
+                n += 1
+            out.append( FRAME_COPY | n )
+            out += levels[led:led + n]
+        led += n
+
+    out.append( FRAME_END )
+    return out
+
+
+def encode( frames ):
+    """ encode a sequence of (ms, levels) """
+    out = []
+    for ms, levels in frames:
+        if not 0 < ms <= 0xffff:
+            sys.exit( "frame duration {} ms out of range".format( ms ) )
+        if len( levels ) != LED_COUNT or not all( 0 <= v <= 255 for v in levels ):
+            sys.exit( "frame needs {} intensities of 0-255".format( LED_COUNT ) )
+        out += [ ms & 0xff, ms >> 8 ] + encode_frame( levels )
+    return out + [ 0, 0 ]
+
+
+def main():
+    parser = argparse.ArgumentParser( description=__doc__.split( '\n' )[0] )
+    parser.add_argument( '-o', dest='output', required=True,
+            help="c file to write (and its header)" )
+    parser.add_argument( '-r', dest='radius', type=float, default=0.45,
+            help="led ring radius in GIFs, as a fraction of their size" )
+    parser.add_argument( 'sequences', nargs='*' )
+    args = parser.parse_args()
+
+    header = os.path.splitext( args.output )[0] + ".h"
+    guard = "__{}__".format( re.sub( r'\W', '_', os.path.basename( header ).upper() ) )
+    c_lines = [ "/* generated by scripts/frames2anim.py -- do not edit */",
+            "",
+            '#include "{}"'.format( os.path.basename( header ) ),
+            "" ]
+    h_lines = [ "/* generated by scripts/frames2anim.py -- do not edit */",
+            "",
+            "#ifndef {}".format( guard ),
+            "#define {}".format( guard ),
+            "",
+            "#include <stdint.h>",
+            "" ]
+
+    for path in sorted( args.sequences ):
+        base = os.path.splitext( os.path.basename( path ) )[0]
+        name = "FRAMES_" + re.sub( r'\W', '_', base ).upper()
+
+        if path.lower().endswith( '.gif' ):
+            frames = parse_gif( path, args.radius )
+        else:
+            frames = parse_text( path )
+        data = encode( frames )
+
+        h_lines.append( "extern const uint8_t {}[{}]; /* {} frames */".format(
+            name, len( data ), len( frames ) ) )
+        c_lines.append( "/* {} */".format( path ) )
+        c_lines.append( "const uint8_t {}[{}] = {{".format( name, len( data ) ) )
+        for i in range( 0, len( data ), 12 ):
+            c_lines.append( "  " + " ".join( "0x{:02x},".format( b )
+                for b in data[i:i + 12] ) )
+        c_lines += [ "};", "" ]
+
+        sys.stderr.write( "{}: {} frames, {} bytes\n".format(
+            name, len( frames ), len( data ) ) )
+
+    h_lines += [ "", "#endif /* end of include guard: {} */".format( guard ) ]
+
+    with open( args.output, 'w' ) as f:
+        f.write( "\n".join( c_lines ) + "\n" )
+    with open( header, 'w' ) as f:
+        f.write( "\n".join( h_lines ) + "\n" )
+
+
+if __name__ == '__main__':
+    main()
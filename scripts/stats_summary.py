@@ -0,0 +1,100 @@
+#!/bin/python
+""" show the run time stats (see src/hist.h) logged in a nvm dump
+
+    Records are written by the main loop profiler (src/prof.h, e.g.
+    triple click in the profiler util mode, built with make
+    profile=true) and the wake latency tracer (src/trace.h, every 100
+    wakes when going to sleep, built with make wake_trace=true)
+"""
+import argparse
+import struct
+
+HIST_BINS = 20
+STATS_FMT = "<QIII{}H".format(HIST_BINS)
+STATS_SIZE = struct.calcsize(STATS_FMT)
+
+# per start code: record title, its counters, the name of each set of
+# stats, the unit they're in, units per displayed unit and a note
+RECORDS = {
+    0x70: {
+        "title": "profile",
+        "counters": [ "overruns" ],
+        "names": [ "loop", "main_tic", "anim_tic", "display_tic",
+            "accel_event_flags", "tc_pwm_isr" ],
+        "unit": "us",
+        "per_unit": 8,
+        "note": "(sections include the interrupts taken during them)",
+    },
+    # stats of each point are of the stage ending at it, except for the
+    # first which are of the whole wake
+    0x74: {
+        "title": "wake trace",
+        "counters": [ "wakes", "rejected checks", "skipped" ],
+        "names": [ "wake (total)", "isr->wakeup_check",
+            "accel_wakeup_check", "wdt_enable", "led_controller",
+            "rtc sync", "accel_enable", "wakeup (rest)",
+            "first display_tic" ],
+        "unit": "ms",
+        "per_unit": 32.768,
+        "note": "(stamps each add ~0.15ms to the stage they end)",
+    },
+}
+
+
+def show_record(data, pos, record):
+    """ print the record at pos, returning the position after it """
+    counter_count = len(record["counters"])
+    vals = struct.unpack_from("<i{}I".format(counter_count), data, pos)
+    pos += 4 + 4 * counter_count
+    count = len(record["names"])
+    end = pos + count * STATS_SIZE
+    if end >= len(data) or data[end:end + 1] != bytearray([count]):
+        print("0x{:x}: incomplete {} record".format(pos, record["title"]))
+        return pos
+
+    def units(n):
+        return "{:.2f}".format(n / record["per_unit"])
+
+    print("=== {} at timestamp {}: {} ===".format(record["title"], vals[0],
+        ", ".join("{} {}".format(n, name)
+            for n, name in zip(vals[1:], record["counters"]))))
+    print("{:<20} {:>8} {:>8} {:>8} {:>8}  {}".format("name", "runs",
+        "min", "mean", "max", "{} (log2 histogram)".format(record["unit"])))
+    for name in record["names"]:
+        vals = struct.unpack_from(STATS_FMT, data, pos)
+        total, runs, low, high = vals[:4]
+        hist = vals[4:]
+        pos += STATS_SIZE
+        if not runs:
+            print("{:<20} {:>8}".format(name, 0))
+            continue
+        bins = " ".join("{}:{}".format(units(1 << b), n)
+                for b, n in enumerate(hist) if n)
+        print("{:<20} {:>8} {:>8} {:>8} {:>8}  {}".format(name, runs,
+            units(low), units(total / runs), units(high), bins))
+
+    print(record["note"] + "\n")
+    return end + 1
+
+
+def find_record(data, pos):
+    """ find the next record from pos, returning its position and type """
+    found = [ (data.find(bytes([code] * 3), pos), code) for code in RECORDS ]
+    found = [ f for f in found if f[0] >= 0 ]
+    return min(found) if found else (-1, None)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('dumpfile')
+    args = parser.parse_args()
+
+    with open(args.dumpfile, 'rb') as f:
+        data = f.read()
+
+    pos, code = find_record(data, 0)
+    if pos < 0:
+        print("No profile or wake trace records")
+    while pos >= 0:
+        pos = show_record(data, pos + 3, RECORDS[code])
+        pos, code = find_record(data, pos)
@@ -20,9 +20,9 @@ if __name__ == "__main__":
         exit()
 
     
-    NVM_DATA_SIZE = 35
+    NVM_DATA_SIZE = 42
     binval = f.read(NVM_DATA_SIZE)
-    fmt = "<bBBBIIIIIHBBBBBBHB"
+    fmt = "<bBBBIIIIIHBBBBBBHBBBxHH"
     vals = struct.unpack(fmt, binval)
     log.debug("unpack struct: {}".format(vals))
     rtc_corr = vals[0]
@@ -39,6 +39,10 @@ if __name__ == "__main__":
     month = vals[14]
     year = vals[16]
     pm = vals[17] > 0
+    disp_pool_high_water = vals[18]
+    anim_pool_high_water = vals[19]
+    disp_pool_failures = vals[20]
+    anim_pool_failures = vals[21]
     lifetime_s = lifetime_ticks/TICKS_PER_MS/1000.0
     
     if lifetime_wakes > 0:
@@ -60,3 +64,11 @@ if __name__ == "__main__":
 
     print("RTC Frequency Correction:\t\t {}ppm".format(rtc_corr))
 
+    if disp_pool_high_water != 0xff:
+        print("Display Pool High Water:\t {}".format(disp_pool_high_water))
+        print("Display Pool Failures:\t\t {}".format(disp_pool_failures))
+        print("Animation Pool High Water:\t {}".format(anim_pool_high_water))
+        print("Animation Pool Failures:\t {}".format(anim_pool_failures))
+    else:
+        print("No pool usage data")
+
@@ -0,0 +1,275 @@
+/** file:       asf.h
+  * created:    2026-10-16 10:12:40
+  *
+  * Host stand-in for the parts of ASF used by src/leds.c so the led
+  * scan can be run by sim_leds.c.  PORTA, TC3 and TC4 are plain
+  * structs; register writes are applied by the simulator, which also
+  * plays the role of the timer hardware (see sim_leds.c)
+  */
+
+#ifndef __SIM_ASF_H__
+#define __SIM_ASF_H__
+
+//___ I N C L U D E S ________________________________________________________
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//___ M A C R O S ____________________________________________________________
+#define PIN_PA04    4
+#define PIN_PA05    5
+#define PIN_PA06    6
+#define PIN_PA07    7
+#define PIN_PA11    11
+#define PIN_PA14    14
+#define PIN_PA15    15
+#define PIN_PA16    16
+#define PIN_PA17    17
+#define PIN_PA18    18
+#define PIN_PA19    19
+#define PIN_PA22    22
+#define PIN_PA23    23
+#define PIN_PA24    24
+#define PIN_PA25    25
+#define PIN_PA27    27
+#define PIN_PA28    28
+
+/* Every access folds the previous OUTSET/OUTCLR write into OUT, like
+ * the hardware applying each write as it happens */
+#define PORTA       ( *sim_port_access() )
+
+#define TC3         ( &sim_tc3 )
+#define TC4         ( &sim_tc4 )
+
+#define GCLK_GENERATOR_0                    0
+#define EVSYS_ID_GEN_TC3_OVF                0
+#define EVSYS_ID_GEN_TC4_MCX_4              0
+#define EVSYS_ID_USER_TC4_EVU               0
+#define EVSYS_ID_USER_TC5_EVU               0
+
+#define delay_ms( ms )                      sim_delay_ms( ms )
+
+//___ T Y P E D E F S ________________________________________________________
+typedef struct {
+  uint32_t reg;
+} sim_reg32_t;
+
+typedef struct {
+  uint16_t reg;
+} sim_reg16_t;
+
+typedef struct {
+  uint8_t reg;
+} sim_reg8_t;
+
+typedef struct {
+  sim_reg32_t OUT;
+  sim_reg32_t OUTSET;
+  sim_reg32_t OUTCLR;
+} PortGroup;
+
+struct tc_module;
+typedef void (*tc_callback_t)( struct tc_module *const module );
+
+typedef struct {
+  struct {
+    sim_reg16_t CC[ 2 ];
+    sim_reg16_t COUNT;
+  } COUNT16;
+  struct {
+    sim_reg8_t COUNT;
+  } COUNT8;
+
+  /* simulator state */
+  bool enabled;
+  bool running;
+  tc_callback_t cc0_callback;
+  bool cc0_callback_enabled;
+} Tc;
+
+enum tc_counter_size {
+  TC_COUNTER_SIZE_8BIT,
+  TC_COUNTER_SIZE_16BIT
+};
+
+enum tc_wave_generation {
+  TC_WAVE_GENERATION_NORMAL_FREQ,
+  TC_WAVE_GENERATION_MATCH_FREQ
+};
+
+enum tc_callback {
+  TC_CALLBACK_CC_CHANNEL0
+};
+
+enum tc_event_action {
+  TC_EVENT_ACTION_OFF,
+  TC_EVENT_ACTION_INCREMENT_COUNTER
+};
+
+enum events_path_selection {
+  EVENTS_PATH_SYNCHRONOUS
+};
+
+enum port_pin_dir {
+  PORT_PIN_DIR_INPUT,
+  PORT_PIN_DIR_OUTPUT
+};
+
+struct tc_module {
+  Tc *hw;
+};
+
+struct tc_config {
+  enum tc_counter_size counter_size;
+  enum tc_wave_generation wave_generation;
+  bool run_in_standby;
+  uint8_t clock_source;
+  struct {
+    uint16_t compare_capture_channel[ 2 ];
+  } counter_16_bit;
+  struct {
+    uint8_t period;
+    uint8_t value;
+  } counter_8_bit;
+};
+
+struct tc_events {
+  bool generate_event_on_overflow;
+  bool generate_event_on_compare_channel[ 2 ];
+  enum tc_event_action event_action;
+  bool on_event_perform_action;
+};
+
+struct events_resource {
+  uint8_t channel;
+};
+
+struct events_config {
+  enum events_path_selection path;
+  uint8_t generator;
+};
+
+struct port_config {
+  enum port_pin_dir direction;
+  bool powersave;
+};
+
+//___ V A R I A B L E S ______________________________________________________
+extern Tc sim_tc3;
+extern Tc sim_tc4;
+
+//___ P R O T O T Y P E S ____________________________________________________
+PortGroup * sim_port_access( void );
+  /* @brief apply pending set/clear register writes to PORTA
+   * @param None
+   * @retrn PORTA
+   */
+
+void sim_delay_ms( uint32_t ms );
+  /* @brief not simulated (no-op)
+   * @param delay in ms
+   * @retrn None
+   */
+
+static inline void tc_get_config_defaults( struct tc_config *const config ) {
+  struct tc_config defaults = { 0 };
+  *config = defaults;
+}
+
+static inline void tc_init( struct tc_module *const module, Tc *const hw,
+    const struct tc_config *const config ) {
+  module->hw = hw;
+  hw->enabled = false;
+  hw->running = true;
+  hw->COUNT16.COUNT.reg = 0;
+  hw->COUNT16.CC[0].reg = config->counter_size == TC_COUNTER_SIZE_16BIT ?
+    config->counter_16_bit.compare_capture_channel[0] :
+    config->counter_8_bit.period;
+}
+
+static inline void tc_enable( struct tc_module *const module ) {
+  module->hw->enabled = true;
+}
+
+static inline void tc_disable( struct tc_module *const module ) {
+  module->hw->enabled = false;
+}
+
+static inline void tc_stop_counter( struct tc_module *const module ) {
+  module->hw->running = false;
+}
+
+static inline void tc_set_count_value( struct tc_module *const module,
+    uint32_t count ) {
+  module->hw->COUNT16.COUNT.reg = count;
+}
+
+static inline void tc_register_callback( struct tc_module *const module,
+    tc_callback_t callback_func, enum tc_callback callback_type ) {
+  module->hw->cc0_callback = callback_func;
+}
+
+static inline void tc_enable_callback( struct tc_module *const module,
+    enum tc_callback callback_type ) {
+  module->hw->cc0_callback_enabled = true;
+}
+
+static inline void tc_disable_callback( struct tc_module *const module,
+    enum tc_callback callback_type ) {
+  module->hw->cc0_callback_enabled = false;
+}
+
+static inline void tc_enable_events( struct tc_module *const module,
+    struct tc_events *const events ) {
+}
+
+static inline void events_get_config_defaults(
+    struct events_config *const config ) {
+  config->path = EVENTS_PATH_SYNCHRONOUS;
+  config->generator = 0;
+}
+
+static inline void events_allocate( struct events_resource *resource,
+    struct events_config *config ) {
+}
+
+static inline void events_attach_user( struct events_resource *resource,
+    uint8_t user_id ) {
+}
+
+static inline void port_get_config_defaults( struct port_config *const config ) {
+  config->direction = PORT_PIN_DIR_INPUT;
+  config->powersave = false;
+}
+
+static inline void port_group_set_config( PortGroup *const port,
+    const uint32_t mask, const struct port_config *const config ) {
+}
+
+static inline void port_group_set_output_level( PortGroup *const port,
+    const uint32_t mask, const uint32_t level_mask ) {
+  port->OUT.reg = (port->OUT.reg & ~mask) | (level_mask & mask);
+}
+
+static inline void port_pin_set_output_level( const uint8_t gpio_pin,
+    const bool level ) {
+  PortGroup *port = sim_port_access();
+
+  if (level) {
+    port->OUT.reg |= 1UL << gpio_pin;
+  } else {
+    port->OUT.reg &= ~(1UL << gpio_pin);
+  }
+}
+
+static inline void system_interrupt_disable_global( void ) {
+}
+
+static inline void system_interrupt_enable_global( void ) {
+}
+
+static inline void __DMB( void ) {
+  __asm volatile ("" ::: "memory");
+}
+
+#endif /* end of include guard: __SIM_ASF_H__ */
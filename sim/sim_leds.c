@@ -0,0 +1,217 @@
+/** file:       sim_leds.c
+  * created:    2026-10-16 10:12:40
+  *
+  * Host simulation of the led multiplexer.  Runs src/leds.c against
+  * the register model in asf.h, playing the part of TC3: each period
+  * lasts CC0 + 1 counts, then the CC0 callback (tc_pwm_isr) is called.
+  * The port state of every period is used to measure each led's duty
+  * cycle and the longest time it is dark (flicker).
+  *
+  * usage: sim_leds [-t ms] [-a fine] [-m level] [led=fine ...]
+  */
+
+//___ I N C L U D E S ________________________________________________________
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "leds.h"
+
+//___ M A C R O S ____________________________________________________________
+#ifndef SIM_TC_FREQ_MHz
+#define SIM_TC_FREQ_MHz     8       /* must match TC_FREQ_MHz in leds.c */
+#endif
+
+#define LED_COUNT           60
+#define BANK_COUNT          5
+#define SEGMENT_COUNT       12
+
+#define SIM_DEFAULT_MS      1000
+
+/* Original bank/segment arithmetic, kept here to check leds.c's tables */
+#define SIM_LED_SEGMENT(i)  ( (i) / BANK_COUNT )
+#define SIM_LED_BANK(i)     \
+  ( SIM_LED_SEGMENT(i) % 2 ? ((i) % 5 ? (5 - ((i) % 5)) : 0 ) : (i) % 5 )
+
+#define COUNTS_TO_MS( c )   ( (double) (c) / (SIM_TC_FREQ_MHz * 1000.0) )
+
+//___ T Y P E D E F S ________________________________________________________
+typedef struct sim_led_t {
+  uint8_t fine;             // requested intensity
+  uint32_t bank_pin_mask;
+  uint32_t segment_pin_mask;
+  uint64_t on_counts;
+  uint64_t dark_since;      // count the led last went dark
+  uint64_t max_dark;
+  bool lit;
+  bool seen_lit;
+} sim_led_t;
+
+//___ V A R I A B L E S ______________________________________________________
+Tc sim_tc3;
+Tc sim_tc4;
+
+extern const uint8_t LED_BANK_GPIO_PINS[];
+extern const uint8_t LED_SEGMENT_GPIO_PINS[];
+
+static PortGroup porta;
+static sim_led_t leds[ LED_COUNT ];
+
+//___ P R O T O T Y P E S ____________________________________________________
+static void usage( const char *name );
+  /* @brief print usage and exit
+   * @param program name
+   * @retrn None
+   */
+
+static void sim_period( uint64_t now, uint32_t counts );
+  /* @brief account the current port state for a timer period
+   * @param count the period starts at
+   * @param length of the period in counts
+   * @retrn None
+   */
+
+//___ F U N C T I O N S ______________________________________________________
+PortGroup * sim_port_access( void ) {
+  porta.OUT.reg |= porta.OUTSET.reg;
+  porta.OUT.reg &= ~porta.OUTCLR.reg;
+  porta.OUTSET.reg = 0;
+  porta.OUTCLR.reg = 0;
+
+  return &porta;
+}
+
+void sim_delay_ms( uint32_t ms ) {
+}
+
+static void usage( const char *name ) {
+  fprintf(stderr, "usage: %s [-t ms] [-a fine] [-m level] [led=fine ...]\n"
+      "  -t ms    simulated time (default %d)\n"
+      "  -a fine  set all leds to a fine intensity (0-%d)\n"
+      "  -m level then cap the shown face at a brightness level (as a\n"
+      "           brightness step does to a static face)\n"
+      "  led=fine set one led (0-%d)\n",
+      name, SIM_DEFAULT_MS, LED_FINE_MAX, LED_COUNT - 1);
+  exit(1);
+}
+
+static void sim_period( uint64_t now, uint32_t counts ) {
+  uint32_t out = sim_port_access()->OUT.reg;
+  sim_led_t *led;
+  bool on;
+  uint8_t i;
+
+  for (i = 0; i < LED_COUNT; i++) {
+    led = &leds[i];
+
+    /* Banks are active low, segments active high */
+    on = !(out & led->bank_pin_mask) && (out & led->segment_pin_mask);
+
+    if (on) {
+      if (led->seen_lit && !led->lit && now - led->dark_since > led->max_dark) {
+        led->max_dark = now - led->dark_since;
+      }
+      led->on_counts += counts;
+      led->seen_lit = true;
+    } else if (led->lit) {
+      led->dark_since = now;
+    }
+    led->lit = on;
+  }
+}
+
+int main( int argc, char **argv ) {
+  uint32_t sim_ms = SIM_DEFAULT_MS;
+  uint64_t end, now = 0;
+  uint64_t isr_calls = 0;
+  uint32_t counts;
+  double duty_pct;
+  int opt, led, fine;
+  int max_level = -1;
+  int i;
+
+  for (i = 0; i < LED_COUNT; i++) {
+    leds[i].bank_pin_mask = 1UL << LED_BANK_GPIO_PINS[ SIM_LED_BANK(i) ];
+    leds[i].segment_pin_mask = 1UL << LED_SEGMENT_GPIO_PINS[ SIM_LED_SEGMENT(i) ];
+  }
+
+  while ((opt = getopt(argc, argv, "t:a:m:h")) != -1) {
+    switch (opt) {
+      case 't':
+        sim_ms = strtoul(optarg, NULL, 0);
+        break;
+      case 'a':
+        fine = atoi(optarg);
+        for (i = 0; i < LED_COUNT; i++) leds[i].fine = fine;
+        break;
+      case 'm':
+        max_level = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+
+  for (i = optind; i < argc; i++) {
+    if (sscanf(argv[i], "%d=%d", &led, &fine) != 2 ||
+        led < 0 || led >= LED_COUNT || fine < 0 || fine > LED_FINE_MAX) {
+      usage(argv[0]);
+    }
+    leds[led].fine = fine;
+  }
+
+  led_controller_init();
+  led_controller_enable();
+
+  for (i = 0; i < LED_COUNT; i++) {
+    led_set_intensity_fine( i, leds[i].fine );
+  }
+  led_commit();
+
+  if (max_level >= 0) {
+    led_set_max_brightness( max_level );
+    led_commit();
+  }
+
+  /* TC3 in match frequency mode: the count restarts on a CC0 match,
+   * which calls the callback.  A top written by the callback sets
+   * the length of the period that just started */
+  end = (uint64_t) sim_ms * SIM_TC_FREQ_MHz * 1000;
+  while (now < end) {
+    if (!sim_tc3.enabled) {
+      /* scan stopped */
+      sim_period(now, end - now);
+      now = end;
+      break;
+    }
+
+    counts = sim_tc3.COUNT16.CC[0].reg + 1 - sim_tc3.COUNT16.COUNT.reg;
+    sim_tc3.COUNT16.COUNT.reg = 0;
+    sim_period(now, counts);
+    now += counts;
+
+    if (sim_tc3.cc0_callback && sim_tc3.cc0_callback_enabled) {
+      sim_tc3.cc0_callback(NULL);
+      isr_calls++;
+    }
+  }
+
+  printf("simulated %u ms, %.0f isr calls/s\n\n", sim_ms,
+      isr_calls * 1000.0 / sim_ms);
+  printf(" led  fine  duty(%%)  max dark(ms)\n");
+
+  for (i = 0; i < LED_COUNT; i++) {
+    if (!leds[i].fine && !leds[i].on_counts) continue;
+
+    duty_pct = 100.0 * leds[i].on_counts / now;
+    printf("  %2d   %3u  %7.3f  ", i, leds[i].fine, duty_pct);
+    if (leds[i].on_counts) {
+      printf("%12.3f%s\n", COUNTS_TO_MS(leds[i].max_dark),
+          leds[i].fine ? "" : "  (not set!)");
+    } else {
+      printf("%12s\n", "never lit");
+    }
+  }
+
+  return 0;
+}
@@ -8,6 +8,7 @@
 #include "main.h"
 #include "leds.h"
 #include "aclock.h"
+#include "trace.h"
 
 // TODO : on super Y, turn off when y low / z high
 
@@ -374,6 +375,12 @@ static bool check_tilt_not_viewable( int16_t x, int16_t y, int16_t z );
      * @retrn true when tilted down
      */
 
+static inline uint32_t ms_until( uint32_t now_ms, uint32_t event_ms );
+    /* @brief time remaining until a wake time (ms) is reached
+     * @param current wake time, wake time of event
+     * @retrn ms remaining (0 if already passed)
+     */
+
 
 
 //___ V A R I A B L E S ______________________________________________________
@@ -394,6 +401,13 @@ static uint16_t i2c_addr = AX_ADDRESS0;
 
 static uint32_t last_click_time_ms;
 
+/* tilt (turn down) detection for entering sleep. Timeouts are
+ * based on main wake time */
+static bool tilt_down = false;
+static bool tilt_not_viewable = false;
+static uint32_t tilt_down_timeout_ms = 0;
+static uint32_t tilt_not_viewable_timeout_ms = 0;
+
 static struct i2c_master_module i2c_master_instance;
 
 static click_flags_t click_flags;
@@ -694,6 +708,8 @@ const macc_fltr_t syh_fltrs[] =
 
 //___ I N T E R R U P T S  ___________________________________________________
 static void accel_isr(void) {
+    trace_point(TRACE_ACCEL_ISR);
+
     if (!accel_register_consecutive_read(AX_REG_CLICK_SRC, 1, &click_flags.b8)) {
         DISP_ERR_CONSEC_READ_1();
     }
@@ -1320,6 +1336,8 @@ bool accel_wakeup_check( void ) {
     wakeup = wake_check();
     extint_chan_enable_callback(AX_INT_CHAN, EXTINT_CALLBACK_TYPE_DETECT);
 
+    trace_point(TRACE_ACCEL_CHECK);
+
     return wakeup;
 }
 
@@ -1452,6 +1470,36 @@ static event_flags_t click_timeout_event_check( void ) {
     return EV_FLAG_NONE;
 }
 
+static inline uint32_t ms_until( uint32_t now_ms, uint32_t event_ms ) {
+    return event_ms > now_ms ? event_ms - now_ms : 0;
+}
+
+uint32_t accel_ms_to_timeout( void ) {
+    uint32_t now_ms = main_get_waketime_ms();
+    uint32_t due_ms = ACCEL_NO_TIMEOUT;
+
+    /* Timeouts fire once wake time has passed (not reached) the window */
+    if (fast_click_counter > 0) {
+        due_ms = min(due_ms, ms_until(now_ms,
+                    last_click_time_ms + FAST_CLICK_WINDOW_MS + 1));
+    }
+
+    if (slow_click_counter > 0) {
+        due_ms = min(due_ms, ms_until(now_ms,
+                    last_click_time_ms + SLOW_CLICK_WINDOW_MS + 1));
+    }
+
+    if (tilt_down && now_ms <= tilt_down_timeout_ms) {
+        due_ms = min(due_ms, tilt_down_timeout_ms + 1 - now_ms);
+    }
+
+    if (tilt_not_viewable && now_ms <= tilt_not_viewable_timeout_ms) {
+        due_ms = min(due_ms, tilt_not_viewable_timeout_ms + 1 - now_ms);
+    }
+
+    return due_ms;
+}
+
 void accel_events_clear( void ) {
     fast_click_counter = 0;
     slow_click_counter = 0;
@@ -1468,13 +1516,6 @@ event_flags_t accel_event_flags( void ) {
     const uint32_t SLEEP_DOWN_DUR_MS = 200;
     const uint32_t SLEEP_NOT_VIEWABLE_DUR_MS = 200;
     
-    /* timestamp (based on main tic count) of most recent
-     * y down interrupt for entering sleep on z-low
-     */
-    static bool tilt_down = false;
-    static bool tilt_not_viewable = false;
-    static uint32_t tilt_down_timeout_ms = 0;
-    static uint32_t tilt_not_viewable_timeout_ms = 0;
 #ifdef NO_ACCEL
     return ev_flags;
 #endif
@@ -12,6 +12,9 @@
 //___ M A C R O S ____________________________________________________________
 #define ACCEL_VALUE_1G  32
 
+/* accel_ms_to_timeout() result when no timeout is pending */
+#define ACCEL_NO_TIMEOUT    0xffffffff
+
 
 //___ T Y P E D E F S ________________________________________________________
 
@@ -35,6 +38,13 @@ event_flags_t accel_event_flags( void );
    * @retrn ev flags (e.g. SCLICK_X, DCLICK_Z, etc.)
    */
 
+uint32_t accel_ms_to_timeout( void );
+  /* @brief time until the next click window or tilt timeout
+   * expires (i.e. when accel_event_flags needs to be checked)
+   * @param None
+   * @retrn ms until due (0 if already due) or ACCEL_NO_TIMEOUT
+   */
+
 void accel_events_clear( void );
   /* @brief Reset click event counters
    * @param None
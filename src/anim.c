@@ -8,21 +8,59 @@
 #include "main.h"
 
 //___ M A C R O S   ( P R I V A T E ) ________________________________________
+#ifndef MAX_ANIMATION_ALLOCS
 #define MAX_ANIMATION_ALLOCS 8
+#endif
+
+/* Fades step through up to 2^N fractional levels per brightness level */
+#define FADE_SUBSTEP_SHIFT_MAX  3
+
+/* Positions in 1/256ths of an led */
+#define POS_FRAC_CIRCLE         ( 60 * 256 )
+
+/* Swirls faster than this per led move several leds an update instead
+ * (anti-aliased), so they don't need a faster tick */
+#define SWIRL_UPDATE_TICKS      MS_IN_TICKS(16)
+
+/* Keyframe easing curves are Q15 (1.0 = 1 << 15) */
+#define EASE_ONE                ( 1L << 15 )
+#define SPRING_TABLE_SHIFT      5   /* 2^N + 1 spring table entries */
 
-#define ANIM_ERROR_MALLOC_FAIL          ((uint32_t) 1)
 #define ANIM_ERROR_BAD_TYPE( type )    (((uint32_t) 2) \
     | (((uint32_t) type)<<8))
 
+/* Whether tick a is before tick b (wraps after ~24 days) */
+#define TICK_BEFORE( a, b )     ( (int32_t) ((a) - (b)) < 0 )
+
+/* Animations by pool index */
+#define ANIM_AT( i )            ( &anim_pool_items[(i)] )
+#define ANIM_INDEX( anim )      ( (uint8_t) ((anim) - anim_pool_items) )
+
+/* Each member (index i) of a group (index g) */
+#define ANIM_MEMBER_FOREACH( i, g )                                   \
+  for (i = 0; i < anim_pool.fresh; i++)                               \
+    if (ANIM_AT(i)->type != animt_unused && anim_links[i].group == (g))
+
 //___ T Y P E D E F S   ( P R I V A T E ) ____________________________________
 
+/* Animations are kept to 20 bytes (see the pool report at link time) */
+typedef char animation_size_check[ sizeof(animation_t) == 20 ? 1 : -1 ];
+
 //___ P R O T O T Y P E S   ( P R I V A T E ) ________________________________
 
 
 animation_t* anim_alloc ( void );
   /* @brief allocate a new animation object
    * @param None
-   * @retrn the new animation
+   * @retrn the new animation (the overflow animation if none are left)
+   */
+
+void anim_add ( animation_t* ptr );
+  /* @brief start running a new animation, its tick_duration becoming
+   *   its end_tick.  The overflow animation is finished at once instead,
+   *   releasing its component if it autoreleases that
+   * @param pointer to anim to add
+   * @retrn None
    */
 
 void anim_free ( animation_t* ptr );
@@ -36,9 +74,127 @@ void anim_update( animation_t *anim);
    * @retrn None
    */
 
+void anim_rotate_frac( display_comp_t *comp, int16_t step );
+  /* @brief move a component by a fraction of an led
+   * @param component, step in 1/256ths of an led (+ is clockwise)
+   * @retrn None
+   */
+
+int32_t anim_ease( uint8_t ease, uint16_t progress );
+  /* @brief evaluate an easing curve
+   * @param anim_ease_t, progress from 0 to EASE_ONE
+   * @retrn eased progress (Q15, may pass EASE_ONE for springs)
+   */
+
+bool anim_key_value( const anim_key_t keys[], uint8_t key_count,
+    uint8_t prop, uint16_t ms, int16_t *value );
+  /* @brief interpolate a property between its keys
+   * @param keys, # of keys, anim_prop_t, time in ms, set to the value
+   * @retrn false if the property has no keys
+   */
+
+void anim_keys_apply( animation_t *anim, display_comp_t *comp );
+  /* @brief set a component's properties to a keyframe animation's
+   *   values at its elapsed time
+   * @param keyframe animation, its component
+   * @retrn None
+   */
+
+uint16_t anim_frame_ticks( const uint8_t *frame );
+  /* @brief how long a frame of a sequence is shown
+   * @param frame, from its header
+   * @retrn ticks (at least 1)
+   */
+
+void anim_frame_next( animation_t *anim, display_comp_t *comp );
+  /* @brief show the next frame of a frame sequence animation, which is
+   *   then updated after that frame's duration
+   * @param frame sequence animation, its component
+   * @retrn None
+   */
+
+uint16_t anim_keys_ms( animation_t *anim );
+  /* @brief a keyframe animation's elapsed time, wrapped if it loops,
+   *   else stopping at its last key
+   * @param keyframe animation
+   * @retrn elapsed ms
+   */
+
+void anim_schedule( animation_t *anim, uint32_t next_update );
+  /* @brief add an animation to the schedule, due at its next update or
+   *   its ending, whichever is first.  Those with neither are kept in
+   *   the idle list
+   * @param animation (in neither list), tick of its next update
+   * @retrn None
+   */
+
+void anim_unschedule( animation_t *anim );
+  /* @brief remove an animation from the schedule (or idle list)
+   * @param animation
+   * @retrn None
+   */
+
+void anim_run( animation_t *anim );
+  /* @brief run a due animation's updates (or ending) up to now
+   *   and reschedule it
+   * @param animation, removed from the schedule
+   * @retrn None
+   */
+
+void anim_finish( animation_t *anim );
+  /* @brief end an animation, starting the one after it in a sequence
+   *   and finishing its group if it was the last member left
+   * @param animation, removed from the schedule
+   * @retrn None
+   */
+
+void anim_hold( animation_t *anim, const animation_t *after );
+  /* @brief keep a new animation from running until it is started
+   *   (see anim_start), e.g. by the one before it in a sequence
+   * @param animation, the one it waits for (NULL for its group)
+   * @retrn None
+   */
+
+void anim_start( animation_t *anim );
+  /* @brief start a held animation (and the first members of a group)
+   *   from now
+   * @param held animation
+   * @retrn None
+   */
+
 //___ V A R I A B L E S ______________________________________________________
-animation_t animation_allocs[MAX_ANIMATION_ALLOCS] = {{0}};
-animation_t *head_anim_ptr = NULL;
+POOL_DECLARE(anim_pool, animation_t, MAX_ANIMATION_ALLOCS);
+/* handed out when the pool is empty -- it never runs */
+static animation_t overflow_anim;
+uint8_t head_anim = POOL_NONE;   /* schedule, in due order */
+static uint8_t head_idle = POOL_NONE;
+static uint32_t anim_now = 0;     /* ticks elapsed, as seen by anim_tic */
+
+/* keys or frame sequence of each keyframe or frames animation, by
+ * pool index */
+static union {
+  const anim_key_t *keys;
+  const uint8_t *frames;
+  anim_done_cb_t done; //of a group
+} anim_data[MAX_ANIMATION_ALLOCS];
+
+/* sequences and groups, by pool index */
+static struct {
+  uint8_t then; //started when this one finishes
+  uint8_t group; //that this is a member of
+  bool held : 1; //waiting to be started
+  bool head : 1; //started with its group, not by the member before it
+  bool hid_comp : 1; //component hidden while held
+} anim_links[MAX_ANIMATION_ALLOCS];
+
+/* Damped spring step response at 2^-SPRING_TABLE_SHIFT intervals */
+static const uint16_t SPRING_Q15[ (1 << SPRING_TABLE_SHIFT) + 1 ] = {
+      0,  2795,  9716, 18552, 27364, 34728, 39831, 42442,
+  42795, 41427, 39015, 36226, 33611, 31550, 30229, 29669,
+  29760, 30315, 31121, 31982, 32743, 33308, 33636, 33737,
+  33653, 33449, 33187, 32927, 32709, 32559, 32482, 32472,
+  32768,
+};
 const uint8_t flicker_pattern[] =  \
 {60,
  15,
@@ -70,69 +226,400 @@ const uint8_t flicker_pattern[] =  \
 
 //___ F U N C T I O N S   ( P R I V A T E ) __________________________________
 
-animation_t* anim_alloc ( void ) {
+void anim_rotate_frac( display_comp_t *comp, int16_t step ) {
+  int16_t pos = comp->pos * 256 + comp->pos_frac + step;
+
+  if (pos < 0) {
+    pos += POS_FRAC_CIRCLE;
+  } else if (pos >= POS_FRAC_CIRCLE) {
+    pos -= POS_FRAC_CIRCLE;
+  }
+
+  display_comp_update_pos_frac(comp, pos >> 8, pos & 0xff);
+}
+
+int32_t anim_ease( uint8_t ease, uint16_t progress ) {
+  uint32_t p2;
+  uint8_t i;
+  uint16_t frac;
+
+  switch (ease) {
+    case anim_ease_in_out:
+      /* 3p^2 - 2p^3 */
+      p2 = ((uint32_t) progress * progress) >> 15;
+      return 3 * p2 - ((2 * p2 * progress) >> 15);
+    case anim_ease_spring:
+      i = progress >> (15 - SPRING_TABLE_SHIFT);
+      if (i >= (1 << SPRING_TABLE_SHIFT)) return SPRING_Q15[i];
+
+      frac = progress & ((1 << (15 - SPRING_TABLE_SHIFT)) - 1);
+      return SPRING_Q15[i] + ((((int32_t) SPRING_Q15[i + 1] - SPRING_Q15[i])
+            * frac) >> (15 - SPRING_TABLE_SHIFT));
+    case anim_ease_linear:
+    default:
+      return progress;
+  }
+}
+
+bool anim_key_value( const anim_key_t keys[], uint8_t key_count,
+    uint8_t prop, uint16_t ms, int16_t *value ) {
+  const anim_key_t *prev = NULL, *next = NULL;
+  uint16_t progress;
+  int32_t eased;
   uint8_t i;
 
-  for (i=0; i < MAX_ANIMATION_ALLOCS; i++) {
-    if (animation_allocs[i].type == animt_unused) {
-      return &(animation_allocs[i]);
+  for (i = 0; i < key_count; i++) {
+    if (keys[i].prop != prop) continue;
+
+    if (keys[i].time_ms <= ms) {
+      prev = &keys[i];
+    } else {
+      next = &keys[i];
+      break;
     }
   }
 
-  main_terminate_in_error( error_group_animation, ANIM_ERROR_MALLOC_FAIL );
-  return NULL;
+  if (!prev && !next) return false;
+
+  if (!prev || !next) {
+    *value = prev ? prev->value : next->value;
+    return true;
+  }
+
+  progress = ((uint32_t) (ms - prev->time_ms) << 15) /
+    (next->time_ms - prev->time_ms);
+  eased = anim_ease(next->ease, progress);
+
+  /* Q14 keeps the product in 32 bits with spring overshoot */
+  *value = prev->value + ((((int32_t) next->value - prev->value)
+        * (eased >> 1)) >> 14);
+  return true;
+}
+
+void anim_keys_apply( animation_t *anim, display_comp_t *comp ) {
+  const anim_key_t *keys = anim_data[ANIM_INDEX(anim)].keys;
+  uint16_t ms = anim_keys_ms(anim);
+  int16_t value;
+  int32_t pos;
+
+  if (anim_key_value(keys, anim->key_count, anim_prop_pos,
+        ms, &value)) {
+    pos = value;
+    while (pos < 0) pos += POS_FRAC_CIRCLE;
+    while (pos >= POS_FRAC_CIRCLE) pos -= POS_FRAC_CIRCLE;
+    display_comp_update_pos_frac(comp, pos >> 8, pos & 0xff);
+  }
+
+  if (anim_key_value(keys, anim->key_count, anim_prop_length,
+        ms, &value)) {
+    if (value < 1) value = 1;
+    if (value > 60) value = 60;
+    display_comp_update_length(comp, value);
+  }
+
+  if (anim_key_value(keys, anim->key_count, anim_prop_brightness,
+        ms, &value)) {
+    if (value < 0) value = 0;
+    if (value > MAX_BRIGHT_VAL * 256) value = MAX_BRIGHT_VAL * 256;
+    display_comp_update_brightness_frac(comp, value >> 8, value & 0xff);
+  }
+}
+
+uint16_t anim_frame_ticks( const uint8_t *frame ) {
+  uint16_t ticks = MS_IN_TICKS(ANIM_FRAME_MS(frame));
+
+  return ticks ? ticks : 1;
+}
+
+void anim_frame_next( animation_t *anim, display_comp_t *comp ) {
+  const uint8_t *sequence = anim_data[ANIM_INDEX(anim)].frames;
+  const uint8_t *frame = sequence + anim->frame_offset;
+
+  frame = display_frame_end(frame + ANIM_FRAME_HEADER);
+  if (!ANIM_FRAME_MS(frame)) {
+    /* past the last frame, which is held until the ending */
+    if (!anim->frame_loop) return;
+    frame = sequence;
+  }
+
+  anim->frame_offset = frame - sequence;
+  anim->tick_interval = anim_frame_ticks(frame);
+  display_comp_update_frame(comp, frame + ANIM_FRAME_HEADER);
+}
+
+uint16_t anim_keys_ms( animation_t *anim ) {
+  const anim_key_t *keys = anim_data[ANIM_INDEX(anim)].keys;
+  uint16_t end_ms = anim->key_count ? keys[anim->key_count - 1].time_ms : 0;
+  uint16_t ms = TICKS_IN_MS((uint16_t) ((uint16_t) anim_now - anim->key_start));
+  uint16_t wrapped;
+
+  if (ms < end_ms) return ms;
+  if (!anim->key_loop) return end_ms;
+
+  /* restart from the loop(s) passed */
+  wrapped = ms % end_ms;
+  anim->key_start += MS_IN_TICKS(ms - wrapped);
+  return wrapped;
+}
+
+void anim_schedule( animation_t *anim, uint32_t next_update ) {
+  bool updates = anim->enabled && anim->tick_interval;
+  uint8_t i;
+
+  if (!updates && !anim->end_tick) {
+    anim->queued = false;
+    pool_list_append(&anim_pool, &head_idle, ANIM_INDEX(anim));
+    return;
+  }
+
+  anim->due = next_update;
+  if (!updates || (anim->end_tick && !TICK_BEFORE(next_update, anim->end_tick))) {
+    anim->due = anim->end_tick;
+  }
+
+  /* after any due at the same tick, so those run in the order added */
+  for (i = head_anim; i != POOL_NONE; i = ANIM_AT(i)->next) {
+    if (TICK_BEFORE(anim->due, ANIM_AT(i)->due)) break;
+  }
+
+  anim->queued = true;
+  pool_list_insert(&anim_pool, &head_anim, ANIM_INDEX(anim), i);
+}
+
+void anim_unschedule( animation_t *anim ) {
+  pool_list_delete(&anim_pool, anim->queued ? &head_anim : &head_idle,
+      ANIM_INDEX(anim));
+}
+
+void anim_run( animation_t *anim ) {
+  uint32_t next;
+
+  if (anim->end_tick && anim->due == anim->end_tick) {
+    anim_finish(anim);
+    return;
+  }
+
+  if (anim->type == animt_keyframes) {
+    /* Keyframes are evaluated at the elapsed time, so one update
+     * makes up for any number of missed intervals */
+    anim_update(anim);
+    next = anim_now + anim->tick_interval;
+  } else {
+    /* More than one interval may have elapsed if the main tick
+     * was longer than this animation's interval */
+    next = anim->due;
+    do {
+      anim_update(anim);
+      next += anim->tick_interval;
+    } while (!TICK_BEFORE(anim_now, next) &&
+        (!anim->end_tick || TICK_BEFORE(next, anim->end_tick)));
+  }
+
+  anim_schedule(anim, next);
+}
+
+void anim_finish( animation_t *anim ) {
+  uint8_t index = ANIM_INDEX(anim);
+  uint8_t then = anim_links[index].then;
+  uint8_t group = anim_links[index].group;
+  anim_done_cb_t done = anim->type == animt_group ?
+    anim_data[index].done : NULL;
+  animation_t *group_anim;
+
+  /* keyframes finish on their last key's values */
+  if (anim->type == animt_keyframes && anim->enabled) {
+    anim_update(anim);
+  }
+
+  anim->enabled = false;
+  anim->end_tick = 0;
+  anim_links[index].then = POOL_NONE;
+  anim_links[index].group = POOL_NONE;
+  anim_schedule(anim, 0);
+
+  if (anim->autorelease_anim) {
+    anim_release(anim);
+  }
+
+  if (then != POOL_NONE) {
+    anim_start(ANIM_AT(then));
+  }
+
+  if (group != POOL_NONE) {
+    group_anim = ANIM_AT(group);
+    if (!--group_anim->members) {
+      anim_unschedule(group_anim);
+      anim_finish(group_anim);
+    }
+  }
+
+  if (done) done();
+}
+
+void anim_hold( animation_t *anim, const animation_t *after ) {
+  uint8_t index = ANIM_INDEX(anim);
+  display_comp_t *comp = display_comp_at(anim->comp_index);
+  uint8_t i;
+
+  if (anim->type == animt_group) {
+    /* its first members wait instead */
+    ANIM_MEMBER_FOREACH(i, index) {
+      if (anim_links[i].head) anim_hold(ANIM_AT(i), after);
+    }
+  } else if (comp->on && (!after || after->comp_index != anim->comp_index)) {
+    display_comp_hide(comp);
+    anim_links[index].hid_comp = true;
+  }
+
+  /* back to a duration, so it runs as long once started */
+  anim_unschedule(anim);
+  anim->tick_duration = anim->end_tick ?
+    (int32_t) (anim->end_tick - anim_now) : ANIMATION_DURATION_INF;
+  anim->queued = false;
+  pool_list_append(&anim_pool, &head_idle, index);
+  anim_links[index].held = true;
+}
+
+void anim_start( animation_t *anim ) {
+  uint8_t index = ANIM_INDEX(anim);
+  uint8_t i;
+
+  anim_unschedule(anim);
+  anim_links[index].held = false;
+
+  if (anim_links[index].hid_comp) {
+    display_comp_show(display_comp_at(anim->comp_index));
+    anim_links[index].hid_comp = false;
+  }
+
+  if (!anim->enabled) {
+    /* stopped while held */
+    anim->end_tick = 0;
+    anim_finish(anim);
+    return;
+  }
+
+  if (anim->type == animt_keyframes) {
+    anim->key_start = anim_now;
+  }
+  anim_add(anim);
+
+  if (anim->type == animt_group) {
+    ANIM_MEMBER_FOREACH(i, index) {
+      if (anim_links[i].head && anim_links[i].held) anim_start(ANIM_AT(i));
+    }
+  }
+}
+
+animation_t* anim_alloc ( void ) {
+  uint8_t index = pool_alloc(&anim_pool);
+
+  if (index == POOL_NONE) return &overflow_anim;
+
+  anim_links[index].then = POOL_NONE;
+  anim_links[index].group = POOL_NONE;
+  anim_links[index].held = false;
+  anim_links[index].head = false;
+  anim_links[index].hid_comp = false;
+
+  return ANIM_AT(index);
+}
+
+void anim_add ( animation_t* ptr ) {
+  if (ptr == &overflow_anim) {
+    /* It never runs or releases, so neither would a component made
+     * for it */
+    if (ptr->autorelease_disp_comp) {
+      display_comp_hide(display_comp_at(ptr->comp_index));
+      display_comp_release(display_comp_at(ptr->comp_index));
+    }
+    ptr->enabled = false;
+    return;
+  }
+
+  if (ptr->tick_duration > 0) {
+    ptr->end_tick = anim_now + ptr->tick_duration;
+    if (!ptr->end_tick) ptr->end_tick = 1; /* 0 is never */
+  } else {
+    ptr->end_tick = 0;
+  }
+
+  anim_schedule(ptr, anim_now + ptr->tick_interval);
 }
 
 void anim_free ( animation_t* ptr ) {
+  if (ptr == &overflow_anim || ptr->type == animt_unused) return;
+
   ptr->type = animt_unused;
+  pool_free(&anim_pool, ANIM_INDEX(ptr));
 }
 
 
 void anim_update( animation_t *anim ) {
   uint8_t tmp;
+  uint16_t frac, frac_step;
+  display_comp_t *comp = display_comp_at(anim->comp_index);
+
   switch(anim->type) {
     case animt_rotate_cw:
-      display_comp_update_pos(anim->disp_comp,
-          (anim->disp_comp->pos + anim->step) % 60);
+      if (anim->frac_step) {
+        anim_rotate_frac(comp, anim->frac_step);
+        break;
+      }
+      display_comp_update_pos(comp,
+          (comp->pos + anim->step) % 60);
       break;
     case animt_rotate_ccw:
-      display_comp_update_pos(anim->disp_comp,
-          anim->disp_comp->pos < anim->step ?
-          60 + anim->disp_comp->pos - anim->step :
-          anim->disp_comp->pos - anim->step);
+      if (anim->frac_step) {
+        anim_rotate_frac(comp, -anim->frac_step);
+        break;
+      }
+      display_comp_update_pos(comp,
+          comp->pos < anim->step ?
+          60 + comp->pos - anim->step :
+          comp->pos - anim->step);
       break;
     case animt_rand:
-      display_comp_update_pos(anim->disp_comp,
+      display_comp_update_pos(comp,
           rand() % 60);
       break;
     case animt_fade_inout:
-      if (anim->disp_comp->brightness == anim->bright_end) {
+      if (comp->brightness == anim->bright_end && !comp->brightness_frac) {
         tmp = anim->bright_end;
         anim->bright_end = anim->bright_start;
         anim->bright_start = tmp;
       }
 
-      display_comp_update_brightness(anim->disp_comp,
-          anim->disp_comp->brightness < anim->bright_end ?
-          anim->disp_comp->brightness + 1 :
-          anim->disp_comp->brightness - 1);
+      /* step is the substep shift, i.e. 2^step updates per level */
+      frac_step = 256 >> anim->step;
+      if (comp->brightness < anim->bright_end) {
+        frac = comp->brightness_frac + frac_step;
+        display_comp_update_brightness_frac(comp,
+            comp->brightness + (frac >> 8), frac & 0xff);
+      } else if (comp->brightness_frac >= frac_step) {
+        display_comp_update_brightness_frac(comp,
+            comp->brightness, comp->brightness_frac - frac_step);
+      } else {
+        display_comp_update_brightness_frac(comp,
+            comp->brightness - 1, comp->brightness_frac + 256 - frac_step);
+      }
 
       break;
     case animt_cut:
       /* main tic will take care of this */
       break;
     case animt_blink:
-      if (anim->disp_comp->on) {
-        display_comp_hide(anim->disp_comp);
+      if (comp->on) {
+        display_comp_hide(comp);
       } else {
-        display_comp_show(anim->disp_comp);
+        display_comp_show(comp);
       }
       break;
     case animt_yoyo:
-      display_comp_update_length( anim->disp_comp,
-          anim->disp_comp->length + anim->step);
-      if ((anim->step > 0 && anim->disp_comp->length == anim->len) ||
-          (anim->step < 0 && anim->disp_comp->length == 1)) {
+      display_comp_update_length( comp,
+          comp->length + anim->step);
+      if ((anim->step > 0 && comp->length == anim->len) ||
+          (anim->step < 0 && comp->length == 1)) {
         anim->step *= -1;
       }
       break;
@@ -143,13 +630,19 @@ void anim_update( animation_t *anim ) {
         anim->index = 0;
       }
 
-      if (anim->disp_comp->on) {
-        display_comp_hide(anim->disp_comp);
+      if (comp->on) {
+        display_comp_hide(comp);
       } else {
-        display_comp_show(anim->disp_comp);
+        display_comp_show(comp);
       }
 
       break;
+    case animt_keyframes:
+      anim_keys_apply(anim, comp);
+      break;
+    case animt_frames:
+      anim_frame_next(anim, comp);
+      break;
 
     default:
       main_terminate_in_error( error_group_animation,
@@ -167,20 +660,45 @@ animation_t* anim_rotate(display_comp_t *disp_comp,
 
   anim->type = clockwise ? animt_rotate_cw : animt_rotate_ccw;
   anim->enabled = true;
-  anim->disp_comp = disp_comp;
+  anim->comp_index = display_comp_index(disp_comp);
   anim->autorelease_disp_comp = false;
   anim->autorelease_anim = false;
   anim->tick_interval = tick_interval;
-  anim->interval_counter = 0;
   anim->tick_duration = duration;
-  anim->prev = anim->next = NULL;
   anim->step = 1;
+  anim->frac_step = 0;
+
+  anim_add(anim);
+
+  return anim;
+}
+
+animation_t* anim_rotate_smooth(display_comp_t *disp_comp,
+    bool clockwise, uint16_t tick_interval, uint16_t update_interval,
+    int32_t duration) {
+  animation_t *anim = anim_rotate(disp_comp, clockwise, update_interval,
+      duration);
+  uint32_t frac_step;
 
-  DL_APPEND(head_anim_ptr, anim);
+  /* 1/256ths of an led per update, rounded */
+  frac_step = ((uint32_t) update_interval * 256 + tick_interval / 2) /
+    tick_interval;
+  if (frac_step < 1) frac_step = 1;
+  if (frac_step > POS_FRAC_CIRCLE - 256) frac_step = POS_FRAC_CIRCLE - 256;
+  anim->frac_step = frac_step;
 
   return anim;
 }
 
+void anim_rotate_sync( animation_t *anim, int8_t pos ) {
+  display_comp_update_pos(display_comp_at(anim->comp_index), pos);
+
+  if (anim->enabled && anim->queued) {
+    anim_unschedule(anim);
+    anim_schedule(anim, anim_now + anim->tick_interval);
+  }
+}
+
 animation_t* anim_random( display_comp_t *disp_comp,
     uint16_t tick_interval, int32_t duration, bool autorelease) {
 
@@ -191,12 +709,9 @@ animation_t* anim_random( display_comp_t *disp_comp,
   anim->autorelease_disp_comp = autorelease;
   anim->autorelease_anim = autorelease;
   anim->tick_interval = tick_interval;
-  anim->disp_comp = disp_comp;
-  anim->interval_counter = 0;
+  anim->comp_index = display_comp_index(disp_comp);
   anim->tick_duration = duration;
-  anim->prev = anim->next = NULL;
-
-  DL_APPEND(head_anim_ptr, anim);
+  anim_add(anim);
 
   return anim;
 }
@@ -205,9 +720,16 @@ animation_t* anim_swirl(uint8_t start, uint8_t len, uint16_t tick_interval,
     uint32_t distance, bool clockwise) {
   display_comp_t *disp_comp = display_snake(start, BRIGHT_DEFAULT, len, clockwise);
 
-  animation_t *anim = anim_rotate(disp_comp, clockwise, tick_interval,
+  animation_t *anim = anim_rotate_smooth(disp_comp, clockwise, tick_interval,
+      tick_interval < SWIRL_UPDATE_TICKS ? SWIRL_UPDATE_TICKS : tick_interval,
       distance > 0 ? distance * tick_interval : 1);
 
+  if (anim == &overflow_anim) {
+    display_comp_hide(disp_comp);
+    display_comp_release(disp_comp);
+    return anim;
+  }
+
   anim->autorelease_anim = false;
   anim->autorelease_disp_comp = true;
 
@@ -225,21 +747,27 @@ animation_t* anim_fade(display_comp_t *disp_comp,
   anim->enabled = true;
   anim->autorelease_disp_comp = autorelease;
   anim->autorelease_anim = autorelease;
-  anim->disp_comp = disp_comp;
-  anim->tick_interval = tick_interval;
-  anim->interval_counter = 0;
+  anim->comp_index = display_comp_index(disp_comp);
   anim->bright_start = bright_start;
   anim->bright_end = bright_end;
 
+  /* With LED_BCM step through fractional levels for a smooth fade,
+   * keeping the same time per level (so only split evenly divisible
+   * intervals).  Otherwise fractions round down to the same level */
+  anim->step = LED_BCM ? FADE_SUBSTEP_SHIFT_MAX : 0;
+  while (anim->step && tick_interval % (1 << anim->step)) {
+    anim->step--;
+  }
+  anim->tick_interval = tick_interval >> anim->step;
+
   if (cycles != ANIMATION_DURATION_INF)
     anim->tick_duration = cycles * abs(bright_end - bright_start) * tick_interval;
   else
     anim->tick_duration = ANIMATION_DURATION_INF;
 
-  anim->prev = anim->next = NULL;
   display_comp_update_brightness(disp_comp, bright_start);
 
-  DL_APPEND(head_anim_ptr, anim);
+  anim_add(anim);
 
   return anim;
 
@@ -255,13 +783,11 @@ animation_t* anim_cutout(display_comp_t *disp_comp,
   anim->enabled = true;
   anim->autorelease_disp_comp = autorelease;
   anim->autorelease_anim = autorelease;
-  anim->disp_comp = disp_comp;
+  anim->comp_index = display_comp_index(disp_comp);
+  anim->tick_interval = 0; /* no updates, only a duration */
   anim->tick_duration = tick_duration;
-  anim->interval_counter = 0;
 
-  anim->prev = anim->next = NULL;
-
-  DL_APPEND(head_anim_ptr, anim);
+  anim_add(anim);
 
   return anim;
 }
@@ -275,14 +801,11 @@ animation_t* anim_blink(display_comp_t *disp_comp, uint16_t tick_interval,
   anim->enabled = true;
   anim->autorelease_disp_comp = autorelease;
   anim->autorelease_anim = autorelease;
-  anim->disp_comp = disp_comp;
+  anim->comp_index = display_comp_index(disp_comp);
   anim->tick_interval = tick_interval;
   anim->tick_duration = tick_duration;
-  anim->interval_counter = 0;
-
-  anim->prev = anim->next = NULL;
 
-  DL_APPEND(head_anim_ptr, anim);
+  anim_add(anim);
 
   return anim;
 }
@@ -297,15 +820,12 @@ animation_t* anim_flicker(display_comp_t *disp_comp,
   anim->enabled = true;
   anim->autorelease_disp_comp = autorelease;
   anim->autorelease_anim = autorelease;
-  anim->disp_comp = disp_comp;
+  anim->comp_index = display_comp_index(disp_comp);
   anim->tick_interval = MS_IN_TICKS(flicker_pattern[0]);
   anim->index = 1;
   anim->tick_duration = tick_duration;
-  anim->interval_counter = 0;
 
-  anim->prev = anim->next = NULL;
-
-  DL_APPEND(head_anim_ptr, anim);
+  anim_add(anim);
 
   return anim;
 }
@@ -320,7 +840,7 @@ animation_t* anim_yoyo(display_comp_t *disp_comp, uint8_t len,
   anim->enabled = true;
   anim->autorelease_disp_comp = autorelease;
   anim->autorelease_anim = autorelease;
-  anim->disp_comp = disp_comp;
+  anim->comp_index = display_comp_index(disp_comp);
   anim->tick_interval = tick_interval;
 
   if (yos == ANIMATION_DURATION_INF) {
@@ -329,64 +849,271 @@ animation_t* anim_yoyo(display_comp_t *disp_comp, uint8_t len,
     anim->tick_duration = tick_interval * (1 + yos * (len - 1));
   }
 
-  anim->interval_counter = 0;
   anim->len = len;
   anim->step = 0;
 
   if (len > 1)
     anim->step = 1;
 
-  anim->prev = anim->next = NULL;
+  anim_add(anim);
+
+  return anim;
+}
+
+animation_t* anim_keyframes(display_comp_t *disp_comp,
+    const anim_key_t keys[], uint8_t key_count, uint16_t tick_interval,
+    bool loop, bool autorelease) {
+
+  animation_t *anim = anim_alloc();
+  uint16_t end_ms = key_count ? keys[key_count - 1].time_ms : 0;
+
+  anim->type = animt_keyframes;
+  anim->enabled = true;
+  anim->autorelease_disp_comp = autorelease;
+  anim->autorelease_anim = autorelease;
+  anim->comp_index = display_comp_index(disp_comp);
+  anim->tick_interval = tick_interval ? tick_interval : 1;
+  anim->key_start = anim_now;
+  anim->key_count = key_count;
+  anim->key_loop = loop && end_ms;
+
+  if (anim->key_loop) {
+    anim->tick_duration = ANIMATION_DURATION_INF;
+  } else {
+    /* at least a tick, as 0 would never finish */
+    anim->tick_duration = MS_IN_TICKS(end_ms) ? MS_IN_TICKS(end_ms) : 1;
+  }
+
+  if (anim != &overflow_anim) {
+    anim_data[ANIM_INDEX(anim)].keys = keys;
+    anim_keys_apply(anim, disp_comp);
+  }
+
+  anim_add(anim);
+
+  return anim;
+}
+
+animation_t* anim_frames( const uint8_t sequence[], bool loop,
+    bool autorelease ) {
 
-  DL_APPEND(head_anim_ptr, anim);
+  animation_t *anim = anim_alloc();
+  const uint8_t *frame;
+  int32_t ticks = 0;
+
+  anim->type = animt_frames;
+  anim->enabled = true;
+  anim->autorelease_disp_comp = true;
+  anim->autorelease_anim = autorelease;
+  anim->comp_index = POOL_NONE;
+  anim->frame_offset = 0;
+  anim->frame_loop = loop && ANIM_FRAME_MS(sequence);
+  anim->tick_interval = anim_frame_ticks(sequence);
+
+  /* The overflow animation gets no component (see anim_add) */
+  if (anim != &overflow_anim) {
+    anim_data[ANIM_INDEX(anim)].frames = sequence;
+    anim->comp_index = display_comp_index(display_frame(
+          ANIM_FRAME_MS(sequence) ? sequence + ANIM_FRAME_HEADER : NULL));
+  }
+
+  if (anim->frame_loop) {
+    anim->tick_duration = ANIMATION_DURATION_INF;
+  } else {
+    /* as long as its frames are shown, each at least a tick */
+    for (frame = sequence; ANIM_FRAME_MS(frame);
+        frame = display_frame_end(frame + ANIM_FRAME_HEADER)) {
+      ticks += anim_frame_ticks(frame);
+    }
+    anim->tick_duration = ticks ? ticks : 1;
+  }
+
+  anim_add(anim);
+
+  return anim;
+}
+
+animation_t* anim_group( bool sequence, animation_t *members[],
+    uint8_t count, anim_done_cb_t done, bool autorelease ) {
+
+  animation_t *anim = anim_alloc();
+  animation_t *member, *prev = NULL;
+  uint8_t group = POOL_NONE;
+  uint8_t i, index;
+
+  anim->type = animt_group;
+  anim->enabled = true;
+  anim->autorelease_disp_comp = false;
+  anim->autorelease_anim = autorelease;
+  anim->comp_index = POOL_NONE;
+  anim->tick_interval = 0; /* no updates, it ends with its members */
+  anim->tick_duration = ANIMATION_DURATION_INF;
+  anim->members = 0;
+
+  anim_add(anim);
+
+  /* If out of animations the members still run (in sequence), on
+   * their own */
+  if (anim != &overflow_anim) {
+    group = ANIM_INDEX(anim);
+    anim_data[group].done = done;
+  }
+
+  for (i = 0; i < count; i++) {
+    member = members[i];
+    if (!member || !member->enabled) continue;
+
+    index = ANIM_INDEX(member);
+    member->autorelease_anim = true;
+    anim_links[index].group = group;
+    anim->members++;
+
+    if (sequence && prev) {
+      anim_hold(member, prev);
+      anim_links[ANIM_INDEX(prev)].then = index;
+    } else {
+      anim_links[index].head = true;
+    }
+    prev = member;
+  }
+
+  if (anim == &overflow_anim) {
+    if (done) done();
+  } else if (!anim->members) {
+    anim_unschedule(anim);
+    anim_finish(anim);
+  }
 
   return anim;
 }
 
 void anim_stop( animation_t *anim) {
-  if (anim)
-    anim->enabled = false;
+  uint8_t index, i;
+
+  if (!anim || !anim->enabled) return;
+  if (anim == &overflow_anim) return;
+
+  index = ANIM_INDEX(anim);
+  if (anim->type == animt_group) {
+    /* it finishes once its members have */
+    ANIM_MEMBER_FOREACH(i, index) {
+      anim_stop(ANIM_AT(i));
+    }
+    return;
+  }
+
+  anim->enabled = false;
+
+  /* held ones finish as soon as they are started */
+  if (anim_links[index].held) return;
+
+  anim_unschedule(anim);
+  if (!anim->end_tick && (anim_links[index].then != POOL_NONE ||
+        anim_links[index].group != POOL_NONE)) {
+    /* one that never ends would hold up its sequence or group */
+    anim_finish(anim);
+  } else {
+    /* no more updates, but it still ends (and autoreleases) on time */
+    anim_schedule(anim, anim_now);
+  }
 }
 
 void anim_release( animation_t *anim) {
-  if (!anim) return;
+  uint8_t index, i, then;
+  bool spliced = false;
+  animation_t *group_anim;
+
+  if (!anim || anim == &overflow_anim || anim->type == animt_unused) return;
+
+  index = ANIM_INDEX(anim);
+
+  /* a member released early is skipped by its sequence: the one before
+   * it starts the one after it instead */
+  then = anim_links[index].then;
+  anim_links[index].then = POOL_NONE;
+  for (i = 0; i < anim_pool.fresh; i++) {
+    if (ANIM_AT(i)->type != animt_unused && anim_links[i].then == index) {
+      anim_links[i].then = then;
+      spliced = true;
+    }
+  }
+
+  if (then != POOL_NONE && !spliced) {
+    if (anim_links[index].held) {
+      /* first of its sequence, so the next is started with its group */
+      anim_links[then].head = true;
+    } else {
+      anim_start(ANIM_AT(then));
+    }
+  }
+
+  if (anim_links[index].hid_comp) {
+    display_comp_show(display_comp_at(anim->comp_index));
+    anim_links[index].hid_comp = false;
+  }
+
+  /* nor holds up its group */
+  i = anim_links[index].group;
+  if (i != POOL_NONE) {
+    anim_links[index].group = POOL_NONE;
+    group_anim = ANIM_AT(i);
+    if (!--group_anim->members) {
+      anim_unschedule(group_anim);
+      anim_finish(group_anim);
+    }
+  }
 
   if (anim->autorelease_disp_comp) {
-    display_comp_hide(anim->disp_comp);
-    display_comp_release(anim->disp_comp);
+    display_comp_hide(display_comp_at(anim->comp_index));
+    display_comp_release(display_comp_at(anim->comp_index));
   }
 
-  DL_DELETE(head_anim_ptr, anim);
+  /* whatever is left of a group goes with it */
+  if (anim->type == animt_group) {
+    ANIM_MEMBER_FOREACH(i, index) {
+      anim_links[i].then = POOL_NONE;
+    }
+    ANIM_MEMBER_FOREACH(i, index) {
+      anim_links[i].group = POOL_NONE;
+      anim_release(ANIM_AT(i));
+    }
+  }
+
+  anim_unschedule(anim);
   anim_free(anim);
 
 }
 
-void anim_tic( void ) {
-  animation_t *anim = NULL;
-  animation_t *tmp = NULL;
+void anim_tic( uint16_t ticks ) {
+  animation_t *anim;
 
-  DL_FOREACH_SAFE(head_anim_ptr, anim, tmp) {
-    if (anim->tick_duration > 0) {
-      anim->tick_duration--;
-      if (anim->tick_duration == 0) {
-        anim->enabled = false;
+  anim_now += ticks;
 
-        if (anim->autorelease_anim) {
-          anim_release(anim);
-        }
-        continue;
-      }
-    }
-
-    anim->interval_counter++;
-    if (anim->enabled && anim->interval_counter == anim->tick_interval) {
-      anim->interval_counter = 0;
-      anim_update(anim);
-    }
+  /* Only animations that are due are touched */
+  while (head_anim != POOL_NONE) {
+    anim = ANIM_AT(head_anim);
+    if (TICK_BEFORE(anim_now, anim->due)) break;
 
+    anim_unschedule(anim);
+    anim_run(anim);
   }
 }
 
+uint16_t anim_next_deadline( void ) {
+  int32_t ticks;
+
+  if (head_anim == POOL_NONE) return ANIM_TICKS_IDLE;
+
+  ticks = ANIM_AT(head_anim)->due - anim_now;
+  if (ticks < 1) return 1;
+
+  return ticks < ANIM_TICKS_IDLE ? ticks : ANIM_TICKS_IDLE - 1;
+}
+
+const pool_t * anim_get_pool( void ) {
+  return &anim_pool;
+}
+
 void anim_init( void ) {
 }
 
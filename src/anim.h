@@ -8,16 +8,33 @@
 
 //___ I N C L U D E S ________________________________________________________
 #include "display.h"
-#include "utlist.h"
+#include "pool.h"
 
 //___ M A C R O S ____________________________________________________________
 #define ANIMATION_DURATION_INF -1
 
+/* anim_next_deadline() result when no animation needs updating */
+#define ANIM_TICKS_IDLE     0xffff
+
 #define BLINK_INT_DEFAULT   MS_IN_TICKS(100)
 #define BLINK_INT_FAST      MS_IN_TICKS(50)
 #define BLINK_INT_MED       MS_IN_TICKS(200)
 #define BLINK_INT_SLOW      MS_IN_TICKS(500)
 
+/* Frame sequences (see anim_frames and scripts/frames2anim.py) are frames
+ * one after another, each a 16-bit little endian duration in ms followed
+ * by its leds (see DISPLAY_FRAME_*).  A 0 ms duration ends the sequence */
+#define ANIM_FRAME_HEADER   2
+#define ANIM_FRAME_MS( f )  ( (uint16_t) ((f)[0] | ((f)[1] << 8)) )
+
+/* Run animations one after another (see anim_group), e.g.
+ * anim_sequence(done, true, anim_swirl(...), anim_yoyo(...)) */
+#define ANIM_MEMBERS( ... ) \
+    (animation_t *[]) { __VA_ARGS__ }, \
+    sizeof((animation_t *[]) { __VA_ARGS__ }) / sizeof(animation_t *)
+#define anim_sequence( done, autorelease, ... ) \
+    anim_group(true, ANIM_MEMBERS(__VA_ARGS__), (done), (autorelease))
+
 //___ T Y P E D E F S ________________________________________________________
 
 typedef enum {
@@ -30,30 +47,81 @@ typedef enum {
     animt_cut,
     animt_yoyo,
     animt_flicker,
+    animt_keyframes,
+    animt_frames,
+    animt_group,
 } animation_type_t;
 
+/* Animated properties of a display component */
+typedef enum {
+    anim_prop_pos = 0,      //value in 1/256ths of an led (may wrap past 60)
+    anim_prop_length,       //value in leds
+    anim_prop_brightness,   //value in 1/256ths of a brightness level
+} anim_prop_t;
+
+/* How a property moves from its previous key to the next */
+typedef enum {
+    anim_ease_linear = 0,
+    anim_ease_in_out,       //smoothstep
+    anim_ease_spring,       //overshoots then settles
+} anim_ease_t;
+
+typedef struct anim_key_t {
+    uint16_t time_ms; //from the start of the animation
+    int16_t value; //see anim_prop_t
+    uint8_t prop; //anim_prop_t
+    uint8_t ease; //anim_ease_t, curve from the previous key of prop
+} anim_key_t;
+
+/* Called when a group finishes (see anim_group) */
+typedef void (*anim_done_cb_t)( void );
+
 typedef struct animation_t {
-    display_comp_t *disp_comp;
-    uint16_t interval_counter;
+    union {
+      int32_t tick_duration; //duration in ticks, until started
+      uint32_t end_tick; //tick it ends at once started (0 = never)
+    };
+    uint32_t due; //tick of the next update or ending, once started
     uint16_t tick_interval; //update interval in ticks
-    int32_t tick_duration; //duration in ticks
 
     union {
-      int8_t step; //only applicable for rotations and yoyos
-      int8_t index; //used for flicker transitioning
+      struct {
+        uint16_t frac_step; //only applicable for smooth rotations (1/256 led)
+
+        union {
+          int8_t step; //only applicable for rotations, yoyos and fades (substep shift)
+          int8_t index; //used for flicker transitioning
+        };
+
+        uint8_t len; //only applicable for yoyos
+        uint8_t bright_start; //only applicable for fades
+        uint8_t bright_end; //only applicable for fades
+      };
+
+      struct { //only applicable for keyframes
+        uint16_t key_start; //tick the keys (last) started, low 16 bits
+        uint8_t key_count;
+        bool key_loop; //restart at the last key's time
+      };
+
+      struct { //only applicable for frame sequences
+        uint16_t frame_offset; //of the frame shown, in its sequence
+        bool frame_loop; //restart after the last frame
+      };
+
+      struct { //only applicable for groups
+        uint8_t members; //# not finished
+      };
     };
+    uint8_t comp_index; //display component (see display_comp_at)
 
-    uint8_t len; //only applicable for yoyos
-    uint8_t bright_start; //only applicable for fades
-    uint8_t bright_end; //only applicable for fades
-
-    struct animation_t *next, *prev;
-
-    animation_type_t type;
-    bool enabled;
-    bool autorelease_disp_comp; //for display components we allocate
-    bool autorelease_anim; //for animations we should release at their ending
+    uint8_t next, prev; //animation pool indices (see pool.h)
 
+    uint8_t type : 4; //animation_type_t
+    bool enabled : 1;
+    bool autorelease_disp_comp : 1; //for display components we allocate
+    bool autorelease_anim : 1; //for animations we should release at their ending
+    bool queued : 1; //in the schedule (else the idle list)
 } animation_t;
 
 //___ V A R I A B L E S ______________________________________________________
@@ -70,6 +138,30 @@ animation_t* anim_rotate( display_comp_t *disp_comp,
    *    ANIMATION_DURATION_INF for indefinite animation
    * @retrn animation reference handle
    */
+animation_t* anim_rotate_smooth( display_comp_t *disp_comp,
+        bool clockwise, uint16_t tick_interval, uint16_t update_interval,
+        int32_t duration);
+  /* @brief same as anim_rotate() but updated at its own interval, moving
+   *    the fraction of an led (or leds) the rate calls for.  Positions in
+   *    between leds are anti-aliased, so a hand moves smoothly at a slow
+   *    update interval and a fast swirl doesn't need a fast one
+   * @param disp_comp - display component to animate (not a polygon)
+   * @param clockwise - true for clockwise rotation, false for opposite (ccw)
+   * @param tick_interval - rotation rate in ticks per led
+   * @param update_interval - ticks between updates
+   * @param duration - duration of animation in ticks or
+   *    ANIMATION_DURATION_INF for indefinite animation
+   * @retrn animation reference handle
+   */
+
+void anim_rotate_sync( animation_t *anim, int8_t pos );
+  /* @brief move a rotation's component to a whole led and restart its
+   *    update interval from now (e.g. to keep a hand on the clock)
+   * @param anim - rotation animation
+   * @param pos - led
+   * @retrn None
+   */
+
 animation_t* anim_random( display_comp_t *disp_comp,
         uint16_t tick_interval, int32_t duration, bool autorelease );
   /* @brief animate display comp with random positions
@@ -87,7 +179,8 @@ animation_t* anim_swirl(uint8_t start, uint8_t len, uint16_t tick_interval,
    *  animating a finite swirling snake
    * @param start - starting pos (0-60)
    * @param len - snake length
-   * @param tick_interval - rotation rate in ticks
+   * @param tick_interval - rotation rate in ticks per led.  Faster swirls
+   *    are updated every 16ms, moving several leds (anti-aliased)
    * @param distance - # of steps before finishing (i.e. 60 is a full circle)
    * @param clockwise - true for clockwise rotation, false for opposite (ccw)
    * @retrn handle to swirl animation object
@@ -154,12 +247,66 @@ animation_t* anim_yoyo(display_comp_t *disp_comp, uint8_t len,
    * @retrn animation object
    */
 
+animation_t* anim_keyframes(display_comp_t *disp_comp,
+        const anim_key_t keys[], uint8_t key_count, uint16_t tick_interval,
+        bool loop, bool autorelease);
+  /* @brief animate the given display component through a list of keys.
+   *    Each property is interpolated between its keys by elapsed time
+   *    (so a slow or skipped tick doesn't change the timing).  Before
+   *    its first key a property holds that key's value, and after its
+   *    last, the last value
+   * @param disp_comp - display component to animate
+   * @param keys - keys in time order (not copied, so must stay valid)
+   * @param key_count - # of keys
+   * @param tick_interval - interval between updates in ticks
+   * @param loop - restart when the last key's time is reached, else
+   *    finish there
+   * @param autorelease - if animation and display comp should be freed at completion
+   * @retrn animation object
+   */
+
+animation_t* anim_frames( const uint8_t sequence[], bool loop,
+        bool autorelease );
+  /* @brief play a sequence of frames (e.g. from artwork encoded at build
+   *    time), showing each for its duration.  Each frame is decoded
+   *    from the sequence as it is drawn, so it may stay in flash
+   * @param sequence - frame sequence (see ANIM_FRAME_MS), not copied so
+   *    must stay valid
+   * @param loop - restart after the last frame, else finish at its end
+   * @param autorelease - if animation should be freed at completion.  Its
+   *    frame display component is always freed with it
+   * @retrn animation object.  Its display component (see
+   *    display_comp_at) may be moved to another layer
+   */
+
+animation_t* anim_group( bool sequence, animation_t *members[],
+        uint8_t count, anim_done_cb_t done, bool autorelease );
+  /* @brief group animations (normally just created) to run one after
+   *    another or all at once, finishing when all of them have.  Members
+   *    of a sequence after the first are held until the one before them
+   *    finishes, their display component hidden until then (unless the
+   *    one before animates it too).  Members belong to the group: each is
+   *    released as it finishes (its component only if it autoreleases
+   *    that) and any left when the group is released.  A member released
+   *    early is skipped, the rest of the sequence going on without it.
+   *    Stopping the group stops them all.  Groups may be members of other
+   *    groups
+   * @param sequence - true to run the members in order, else together
+   * @param members - animations (NULL or finished ones are skipped)
+   * @param count - # of members
+   * @param done - called when the group finishes (or NULL), last of all
+   *    so it may start other animations
+   * @param autorelease - if the group should be freed at completion
+   * @retrn group animation (see anim_sequence)
+   */
+
 static inline animation_t* anim_snake_grow( uint8_t pos,
         uint8_t len, uint16_t tick_interval, bool autorelease) {
     display_comp_t *comp_ptr = display_snake(pos, MAX_BRIGHT_VAL,
                         1, true);
-    animation_t *anim_ptr = anim_yoyo(comp_ptr, len, tick_interval, 1, autorelease);
-    anim_ptr->autorelease_disp_comp = true;
+    /* the snake goes with it, or at once if out of animations */
+    animation_t *anim_ptr = anim_yoyo(comp_ptr, len, tick_interval, 1, true);
+    anim_ptr->autorelease_anim = autorelease;
     return anim_ptr;
 }
 
@@ -218,12 +365,25 @@ void anim_release( animation_t *anim );
    * @retrn None
    */
 
-void anim_tic( void );
+void anim_tic( uint16_t ticks );
   /* @brief animation update function
-   * @param None
+   * @param ticks - # of ticks elapsed since the previous call
    * @retrn None
    */
 
+uint16_t anim_next_deadline( void );
+  /* @brief # of ticks until the next animation update or ending is due
+   *   (i.e. how long the main loop may sleep for the animations)
+   * @param None
+   * @retrn ticks until due or ANIM_TICKS_IDLE if no update is pending
+   */
+
+const pool_t * anim_get_pool( void );
+  /* @brief animation pool usage (high water mark, failures)
+   * @param None
+   * @retrn animation pool
+   */
+
 void anim_init( void );
   /* @brief initialize animation module
    * @param None
@@ -161,12 +161,21 @@
 #  define CONF_CLOCK_GCLK_2_OUTPUT_ENABLE         false
 
 /* Configure GCLK generator 3 */
-#if RTC_CALIBRATE
+#ifndef WAKE_TRACE
+#define WAKE_TRACE false
+#endif
+
+#if RTC_CALIBRATE || WAKE_TRACE
 #  define CONF_CLOCK_GCLK_3_ENABLE                true 
 #else
 #  define CONF_CLOCK_GCLK_3_ENABLE                false
-#endif /* RTC_CALIBRATE */
+#endif /* RTC_CALIBRATE || WAKE_TRACE */
+#if WAKE_TRACE
+/* keeps the wake tracer's counter (TCC1) running in standby */
+#  define CONF_CLOCK_GCLK_3_RUN_IN_STANDBY        true
+#else
 #  define CONF_CLOCK_GCLK_3_RUN_IN_STANDBY        false
+#endif /* WAKE_TRACE */
 #  define CONF_CLOCK_GCLK_3_CLOCK_SOURCE          SYSTEM_CLOCK_SOURCE_XOSC32K
 #  define CONF_CLOCK_GCLK_3_PRESCALER             1
 #  define CONF_CLOCK_GCLK_3_OUTPUT_ENABLE         false
@@ -10,6 +10,8 @@
 #include "accel.h"
 #include "display.h"
 #include "utils.h"
+#include "prof.h"
+#include "frames.h"
 
 //___ M A C R O S   ( P R I V A T E ) ________________________________________
 #define CLOCK_MODE_SLEEP_TIMEOUT_TICKS                  MS_IN_TICKS(4500)
@@ -22,6 +24,12 @@
 #define EE_RUN_TIMEOUT_TICKS                            MS_IN_TICKS(3000)
 #define EE_RUN_MIN_INTERTICK                            MS_IN_TICKS(100)
 
+/* Mode update periods.  Fast modes count ticks or sample
+ * sensors every tick; slow modes only show static or
+ * animated components and poll for clicks */
+#define MODE_TICK_PERIOD_FAST                           MS_IN_TICKS(1)
+#define MODE_TICK_PERIOD_SLOW                           MS_IN_TICKS(20)
+
 #define DEFAULT_MODE_TRANS_CHK(ev_flags) \
         (   ev_flags & EV_FLAG_LONG_BTN_PRESS || \
             DCLICK(ev_flags) || \
@@ -36,6 +44,18 @@
 /* Max tick interval for hour animation (so 1 and 2 o'clock are faster) */
 #define MAX_HOUR_ANIM_TICKS     MS_IN_TICKS(40)
 
+/* The seconds hand sweeps smoothly, kept on the clock every second */
+#define SEC_HAND_UPDATE_TICKS   MS_IN_TICKS(125)
+/* and passes under the brighter hands rather than dimming them */
+#define SEC_HAND_LAYER          1
+
+/* The selected mode's point springs into place from a few leds back,
+ * then fades out, before the mode starts */
+#define MODE_TRANS_NUDGE_LEDS   2
+#define MODE_TRANS_SETTLE_MS    600
+#define MODE_TRANS_MS           1200
+#define MODE_TRANS_UPDATE_TICKS MS_IN_TICKS(16)
+
 /* Blink intervals and duration for minute hand */
 #define MIN_BLINK_INT    MS_IN_TICKS(175)
 #define MIN_BLINK_DUR    MS_IN_TICKS(1400)
@@ -49,12 +69,33 @@
  * estimate a good tick timeout count */
 #define EDIT_FINISH_TIMEOUT_TICKS   MS_IN_TICKS(1500)
 
+/* The sensor modes show the charge of the last read as a dim point,
+ * one led per SENSOR_CHARGE_nC_PER_LED (a short read is ~1, a long
+ * one ~40-50) */
+#define SENSOR_CHARGE_nC_PER_LED    100
+
+/* The led charge mode shows charges in full brightness led
+ * equivalents (see led_charge_stats_t), one led each */
+#define LED_CHARGE_POS( charge, full_led ) \
+    ( (charge) / (full_led) > 59 ? 59 : (charge) / (full_led) )
+
 #define CONTROL_MODE_EE     10
-#define UTIL_MODE_COUNT     8
+#if (PROFILE)
+#define UTIL_MODE_COUNT     10
+#else
+#define UTIL_MODE_COUNT     9
+#endif  /* PROFILE */
 /* Util control modes start at index 3 in control mode array (e.g. util mode 1 is
  * index 3, etc)*/
 #define UTIL_CTRL_MODE(n) (n % (UTIL_MODE_COUNT + 1) + 2)
 
+/* Profiler histogram frames: a run for each bin's leds and one for
+ * the led after them (each up to 2 bytes), then the end */
+#define PROF_BIN_LEDS       ( 60 / HIST_BINS )
+#define PROF_FRAME_SIZE     ( HIST_BINS * 4 + 1 )
+#define PROF_SECTION_SHOW_TICKS     MS_IN_TICKS(1000)
+#define PROF_UPDATE_TICKS           MS_IN_TICKS(500)
+
 #ifndef FLICKER_MIN_MODE
   #define FLICKER_MIN_MODE false
 #endif
@@ -77,6 +118,18 @@ bool clock_mode_tic ( event_flags_t event_flags );
    * @retrn flag indicating mode finish
    */
 
+void clock_anim_done( void );
+  /* @brief called when the clock mode's time animation finishes
+   * @param None
+   * @retrn None
+   */
+
+display_comp_t* sec_hand_point( uint8_t second, uint8_t brightness );
+  /* @brief create the seconds hand on its own layer
+   * @param second, brightness level
+   * @retrn seconds hand component
+   */
+
 bool selector_mode_tic( event_flags_t event_flags);
   /* @brief mode for selecting and entering advanced modes
    * @param event flags
@@ -113,6 +166,12 @@ bool vbatt_sense_mode_tic ( event_flags_t event_flags );
    * @retrn flag indicating mode finish
    */
 
+uint8_t sensor_charge_pos( sensor_type_t sensor );
+  /* @brief position showing the charge of a sensor's last read
+   * @param sensor
+   * @retrn led (0-59)
+   */
+
 bool gesture_toggle_mode_tic ( event_flags_t event_flags );
   /* @brief mode to allow user disable gestures indefinitely
    * @param event flags
@@ -159,6 +218,29 @@ bool ee_mode_tic ( event_flags_t event_flags );
    * @retrn true on finish
    */
 
+bool led_charge_mode_tic ( event_flags_t event_flags );
+  /* @brief show the led charge estimate and limiter stats (see
+   * led_get_charge_stats).  Single click restarts them
+   * @param event flags
+   * @retrn true on finish
+   */
+
+#if (PROFILE)
+bool prof_mode_tic ( event_flags_t event_flags );
+  /* @brief show the cycle histogram of a profiled section (see prof.h).
+   * Single click selects the next section, triple click logs the
+   * stats to nvm
+   * @param event flags
+   * @retrn true on finish
+   */
+
+void prof_frame_build( uint8_t *frame, prof_section_t section );
+  /* @brief draw a section's histogram as a display frame
+   * @param frame buffer (at least PROF_FRAME_SIZE bytes), section
+   * @retrn None
+   */
+#endif  /* PROFILE */
+
 
 void set_ee_sleep_timeout(uint32_t timeout_ticks);
 
@@ -170,49 +252,59 @@ ctrl_mode_t control_modes[] = {
     {
         .tic_cb = clock_mode_tic,
         .sleep_timeout_ticks = CLOCK_MODE_SLEEP_TIMEOUT_TICKS,
+        .tick_period = MODE_TICK_PERIOD_SLOW,
     },
     {
         .tic_cb = time_set_mode_tic,
         .sleep_timeout_ticks = TIME_SET_MODE_EDITING_SLEEP_TIMEOUT_TICKS,
+        .tick_period = MODE_TICK_PERIOD_FAST,
     },
     {
         .tic_cb = selector_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(20000),
+        .tick_period = MODE_TICK_PERIOD_SLOW,
     },
     {
         /* UTIL MODE #1 */
 #if (LOG_ACCEL_STREAM_IN_MODE_1)
         .tic_cb = accel_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(1500000),
+        .tick_period = MODE_TICK_PERIOD_FAST,
 #else   /* LOG_ACCEL_STREAM_IN_MODE_1 */
         .tic_cb = sparkle_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(15000),
+        .tick_period = MODE_TICK_PERIOD_SLOW,
 #endif  /* LOG_ACCEL_STREAM_IN_MODE_1 */
     },
     {
         /* UTIL MODE #2 */
         .tic_cb = swirl_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(15000),
+        .tick_period = MODE_TICK_PERIOD_SLOW,
     },
     {
         /* UTIL MODE #3 */
         .tic_cb = light_sense_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(30000),
+        .tick_period = MODE_TICK_PERIOD_FAST,
     },
     {
         /* UTIL MODE #4 */
         .tic_cb = vbatt_sense_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(15000),
+        .tick_period = MODE_TICK_PERIOD_SLOW,
     },
     {
         /* UTIL MODE #5 */
         .tic_cb = gesture_toggle_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(15000),
+        .tick_period = MODE_TICK_PERIOD_SLOW,
     },
     {
         /* UTIL MODE #6 */
         .tic_cb = accel_point_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(15000),
+        .tick_period = MODE_TICK_PERIOD_FAST,
     },
 //    {
 //        /* UTIL MODE #5 */
@@ -223,12 +315,28 @@ ctrl_mode_t control_modes[] = {
         /* UTIL MODE #7 */
         .tic_cb = deep_sleep_enable_mode_tic,
         .sleep_timeout_ticks = MS_IN_TICKS(10000),
+        .tick_period = MODE_TICK_PERIOD_SLOW,
     },
     {
         /* UTIL MODE #8 */
         .tic_cb = ee_mode_tic,
         .sleep_timeout_ticks = EE_MODE_SLEEP_TIMEOUT_TICKS,
-    }
+        .tick_period = MODE_TICK_PERIOD_FAST,
+    },
+    {
+        /* UTIL MODE #9 */
+        .tic_cb = led_charge_mode_tic,
+        .sleep_timeout_ticks = MS_IN_TICKS(30000),
+        .tick_period = MODE_TICK_PERIOD_SLOW,
+    },
+#if (PROFILE)
+    {
+        /* UTIL MODE #10 */
+        .tic_cb = prof_mode_tic,
+        .sleep_timeout_ticks = MS_IN_TICKS(60000),
+        .tick_period = MODE_TICK_PERIOD_SLOW,
+    },
+#endif  /* PROFILE */
 };
 
 static uint32_t disp_vals[9];
@@ -236,20 +344,36 @@ static uint32_t disp_vals[9];
 /* Ticks since entering current mode */
 static uint32_t modeticks = 0;
 
+/* Clock mode's progress through showing the time */
+static enum { INIT, ANIM_TIME, ANIM_DONE, DISP_ALL } clock_phase = INIT;
+
 //___ I N T E R R U P T S  ___________________________________________________
 
 //___ F U N C T I O N S   ( P R I V A T E ) __________________________________
 
+void clock_anim_done( void ) {
+    clock_phase = ANIM_DONE;
+}
+
+display_comp_t* sec_hand_point( uint8_t second, uint8_t brightness ) {
+    display_comp_t *comp = display_point(second, brightness);
+
+    display_layer_set_blend(SEC_HAND_LAYER, display_blend_max);
+    display_comp_set_layer(comp, SEC_HAND_LAYER);
+
+    return comp;
+}
+
 bool clock_mode_tic ( event_flags_t event_flags ) {
     uint8_t hour = 0, minute = 0, second = 0, hour_fifths=0;
     uint16_t hour_anim_tick_int;
-    static enum { INIT, ANIM_HOUR_SWIRL, ANIM_HOUR_YOYO,
-        ANIM_MIN, DISP_ALL } phase = INIT;
 
     static display_comp_t *sec_disp_ptr = NULL;
     static display_comp_t *min_disp_ptr = NULL;
     static display_comp_t *hour_disp_ptr = NULL;
     static animation_t *anim_ptr = NULL;
+    static animation_t *sec_anim_ptr = NULL;
+    static uint8_t sec_hand_second = 0;
 
     if (event_flags & EV_FLAG_SLEEP) {
       goto finish;
@@ -281,7 +405,10 @@ bool clock_mode_tic ( event_flags_t event_flags ) {
 
 #if !(DISABLE_SECONDS)
       if (!sec_disp_ptr) {
-        sec_disp_ptr = display_point(second, BRIGHT_LOW);
+        sec_disp_ptr = sec_hand_point(second, BRIGHT_LOW);
+        sec_anim_ptr = anim_rotate_smooth(sec_disp_ptr, true,
+            MS_IN_TICKS(1000), SEC_HAND_UPDATE_TICKS, ANIMATION_DURATION_INF);
+        sec_hand_second = second;
       }
 #endif  /* DISABLE_SECONDS */
     }
@@ -290,47 +417,28 @@ bool clock_mode_tic ( event_flags_t event_flags ) {
     if (hour_anim_tick_int >= MAX_HOUR_ANIM_TICKS) {
         hour_anim_tick_int = MAX_HOUR_ANIM_TICKS;
     }
-    switch(phase) {
+    switch(clock_phase) {
         case INIT:
 #ifdef NO_TIME_ANIMATION
             min_disp_ptr = display_point(minute, BRIGHT_DEFAULT);
             hour_disp_ptr = display_snake(HOUR_POS(hour), MAX_BRIGHT_VAL,
                       hour_fifths + 1, true);
-            phase = DISP_ALL;
+            clock_phase = DISP_ALL;
 #else
-            if (hour == 1) {
-                /* For hour 1 a swirl doesnt animate, so draw a 'growing snake' */
-                anim_ptr = anim_snake_grow( 0, 5, hour_anim_tick_int, false );
-            } else {
-                anim_ptr = anim_swirl(0, 5, hour_anim_tick_int, 5*(hour - 1), true);
-            }
-
-            phase = ANIM_HOUR_SWIRL;
-#endif
-            break;
-        case ANIM_HOUR_SWIRL:
-            if (anim_is_finished(anim_ptr)) {
-                anim_release(anim_ptr);
-                hour_disp_ptr = display_snake(HOUR_POS(hour), MAX_BRIGHT_VAL,
-                        hour_fifths + 1, true);
-
-                anim_ptr = anim_yoyo(hour_disp_ptr, hour_fifths + 1,
-                        hour_anim_tick_int, 1, false);
-                phase = ANIM_HOUR_YOYO;
-            }
-            break;
-        case ANIM_HOUR_YOYO:
-            if (anim_is_finished(anim_ptr)) {
+            {
                 uint16_t blink_int = MIN_BLINK_INT;
                 uint16_t blink_dur = MIN_BLINK_DUR;
+                animation_t *min_anim_ptr;
 
-                anim_release(anim_ptr);
+                /* Everything is set up at once.  The hands are hidden
+                 * until their animation's turn in the sequence */
+                hour_disp_ptr = display_snake(HOUR_POS(hour), MAX_BRIGHT_VAL,
+                        hour_fifths + 1, true);
                 min_disp_ptr = display_point(minute, BRIGHT_DEFAULT);
 #if FLICKER_MIN_MODE
-                min_disp_ptr->on = false;
-                anim_ptr = anim_flicker(min_disp_ptr,
+                display_comp_hide(min_disp_ptr);
+                min_anim_ptr = anim_flicker(min_disp_ptr,
                   MS_IN_TICKS(1500), false);
-                phase = ANIM_MIN;
 #else
                 if (main_is_low_vbatt()) {
                     /* Blink faster, longer for low batt warning */
@@ -338,31 +446,50 @@ bool clock_mode_tic ( event_flags_t event_flags ) {
                     blink_dur = MIN_BLINK_DUR_LOW_BATT;
                 }
 
-                anim_ptr = anim_blink(min_disp_ptr, blink_int, blink_dur, false);
-                phase = ANIM_MIN;
+                min_anim_ptr = anim_blink(min_disp_ptr, blink_int, blink_dur, false);
 #endif
-            }
 
+                anim_ptr = anim_sequence(clock_anim_done, false,
+                    /* For hour 1 a swirl doesnt animate, so draw a 'growing snake' */
+                    hour == 1 ?
+                      anim_snake_grow( 0, 5, hour_anim_tick_int, false ) :
+                      anim_swirl(0, 5, hour_anim_tick_int, 5*(hour - 1), true),
+                    anim_yoyo(hour_disp_ptr, hour_fifths + 1,
+                        hour_anim_tick_int, 1, false),
+                    min_anim_ptr);
+
+                /* unless the sequence has already finished */
+                if (clock_phase == INIT) clock_phase = ANIM_TIME;
+            }
+#endif
             break;
-        case ANIM_MIN:
-            if (anim_is_finished(anim_ptr)) {
-                anim_release(anim_ptr);
-                anim_ptr = NULL;
-                if (main_user_data.seconds_always_on && !sec_disp_ptr) {
-                  sec_disp_ptr = display_point(second, MIN_BRIGHT_VAL);
-                }
-
-                phase = DISP_ALL;
+        case ANIM_TIME:
+            /* clock_anim_done() moves on */
+            break;
+        case ANIM_DONE:
+            anim_release(anim_ptr);
+            anim_ptr = NULL;
+            if (main_user_data.seconds_always_on && !sec_disp_ptr) {
+              sec_disp_ptr = sec_hand_point(second, MIN_BRIGHT_VAL);
+              sec_anim_ptr = anim_rotate_smooth(sec_disp_ptr, true,
+                  MS_IN_TICKS(1000), SEC_HAND_UPDATE_TICKS,
+                  ANIMATION_DURATION_INF);
+              sec_hand_second = second;
             }
+
+            clock_phase = DISP_ALL;
             break;
 
         case DISP_ALL:
             /* Ensure minute led is on after blinking */
-            display_comp_show_all();
+            display_comp_show(min_disp_ptr);
 
-            /* Double click enables seconds and disables timeout */
-            if (sec_disp_ptr) {
-              display_comp_update_pos(sec_disp_ptr, second);
+            /* Double click enables seconds and disables timeout.  The
+             * hand sweeps between seconds and is put back on the clock
+             * as each one starts */
+            if (sec_disp_ptr && second != sec_hand_second) {
+              anim_rotate_sync(sec_anim_ptr, second);
+              sec_hand_second = second;
             }
 
             display_comp_update_pos(min_disp_ptr, minute);
@@ -378,6 +505,7 @@ bool clock_mode_tic ( event_flags_t event_flags ) {
 finish:
     anim_stop(anim_ptr);
     anim_release(anim_ptr);
+    anim_release(sec_anim_ptr);
     display_comp_release(hour_disp_ptr);
     display_comp_release(min_disp_ptr);
     display_comp_release(sec_disp_ptr);
@@ -385,11 +513,12 @@ finish:
     min_disp_ptr = NULL;
     sec_disp_ptr = NULL;
     anim_ptr = NULL;
+    sec_anim_ptr = NULL;
 
     /* Reset sleep timeout to default */
     control_modes[CONTROL_MODE_SHOW_TIME].sleep_timeout_ticks = CLOCK_MODE_SLEEP_TIMEOUT_TICKS;
 
-    phase = INIT;
+    clock_phase = INIT;
 
     if (MNCLICK(event_flags, 5, 6)) {
         control_mode_set(CONTROL_MODE_SET_TIME);
@@ -404,8 +533,15 @@ finish:
 bool selector_mode_tic( event_flags_t event_flags ) {
     static display_comp_t *selector_disp_ptr = NULL;
     static display_comp_t *all_disp_ptr = NULL;
-    static animation_t *mode_trans_blink = NULL;
+    static animation_t *mode_trans_anim = NULL;
     static uint8_t selected_mode = CONTROL_MODE_SHOW_TIME;
+    static anim_key_t mode_trans_keys[] = {
+        { 0, 0, anim_prop_pos, anim_ease_linear },
+        { MODE_TRANS_SETTLE_MS, 0, anim_prop_pos, anim_ease_spring },
+        { MODE_TRANS_SETTLE_MS, BRIGHT_DEFAULT << 8, anim_prop_brightness,
+            anim_ease_linear },
+        { MODE_TRANS_MS, 0, anim_prop_brightness, anim_ease_in_out },
+    };
 
     if (accel_slow_click_cnt == 0 && modeticks > SELECTOR_MODE_TIMEOUT_TICKS) {
       selected_mode = CONTROL_MODE_SHOW_TIME;
@@ -420,7 +556,7 @@ bool selector_mode_tic( event_flags_t event_flags ) {
         goto finish;
     }
 
-    if (mode_trans_blink && anim_is_finished(mode_trans_blink)) {
+    if (mode_trans_anim && anim_is_finished(mode_trans_anim)) {
         goto finish;
     }
 
@@ -441,8 +577,11 @@ bool selector_mode_tic( event_flags_t event_flags ) {
         selector_disp_ptr = display_point(accel_slow_click_cnt, BRIGHT_DEFAULT);
       }
 
-      display_comp_update_pos(selector_disp_ptr,
-          (accel_slow_click_cnt % (UTIL_MODE_COUNT + 1)) * 5);// * 60/UTIL_MODE_COUNT);
+      /* the transition moves it once a mode is selected */
+      if (!mode_trans_anim) {
+        display_comp_update_pos(selector_disp_ptr,
+            (accel_slow_click_cnt % (UTIL_MODE_COUNT + 1)) * 5);// * 60/UTIL_MODE_COUNT);
+      }
 
     }
 
@@ -454,9 +593,13 @@ bool selector_mode_tic( event_flags_t event_flags ) {
         } else {
           selected_mode = UTIL_CTRL_MODE(accel_slow_click_cnt);
         }
-        if (!mode_trans_blink) {
-          mode_trans_blink = anim_blink(selector_disp_ptr,
-              BLINK_INT_MED, MS_IN_TICKS(1200), false);
+        if (!mode_trans_anim) {
+          mode_trans_keys[1].value = selector_disp_ptr->pos * 256;
+          mode_trans_keys[0].value = mode_trans_keys[1].value -
+            MODE_TRANS_NUDGE_LEDS * 256;
+          mode_trans_anim = anim_keyframes(selector_disp_ptr,
+              mode_trans_keys, sizeof(mode_trans_keys)/sizeof(*mode_trans_keys),
+              MODE_TRANS_UPDATE_TICKS, false, false);
         }
     }
 
@@ -465,10 +608,10 @@ bool selector_mode_tic( event_flags_t event_flags ) {
 finish:
     display_comp_release(selector_disp_ptr);
     display_comp_release(all_disp_ptr);
-    anim_release(mode_trans_blink);
+    anim_release(mode_trans_anim);
     selector_disp_ptr = NULL;
     all_disp_ptr = NULL;
-    mode_trans_blink = NULL;
+    mode_trans_anim = NULL;
 
     control_mode_set(selected_mode);
 
@@ -1261,6 +1404,10 @@ bool ee_mode_tic ( event_flags_t event_flags ) {
                 disp_vals[8] = 0UL;
                 ee_submode_tic = char_disp_mode_tic;
                 break;
+            case 61:
+                /* Play the heartbeat frames (graphics/frames) */
+                anim = anim_frames(FRAMES_HEARTBEAT, true, false);
+                break;
             case 86:
                 disp_vals[0] =  9035768;
                 disp_vals[1] =  0;
@@ -1429,50 +1576,58 @@ bool accel_point_mode_tic ( event_flags_t event_flags ) {
     display_comp_update_pos(disp_pt, utils_spin_tracker_update());
     return false;
 }
+uint8_t sensor_charge_pos( sensor_type_t sensor ) {
+    uint16_t charge_nC = main_get_sensor_stats(sensor)->last_read_charge_nC;
+
+    charge_nC /= SENSOR_CHARGE_nC_PER_LED;
+    return charge_nC > 59 ? 59 : charge_nC;
+}
+
 bool light_sense_mode_tic ( event_flags_t event_flags ) {
     static display_comp_t *adc_pt = NULL;
+    static display_comp_t *charge_pt = NULL;
     uint16_t adc_val = 0;
 
     set_ee_sleep_timeout(MS_IN_TICKS(30000));
 
     if (!adc_pt) {
         adc_pt = display_point(0, BRIGHT_DEFAULT);
-        port_pin_set_output_level(LIGHT_SENSE_ENABLE_PIN, true);
-    }
-
-    if (main_get_current_sensor() != sensor_light) {
-        main_set_current_sensor(sensor_light);
+        charge_pt = display_point(0, BRIGHT_LOW);
     }
 
-
     if (modeticks % 20  == 0) {
-      main_start_sensor_read();
+      main_sensor_read(sensor_light, NULL);
     }
 
     if (DEFAULT_MODE_TRANS_CHK(event_flags)) {
         if (adc_pt) {
             display_comp_release(adc_pt);
+            display_comp_release(charge_pt);
             adc_pt = NULL;
+            charge_pt = NULL;
         }
-        port_pin_set_output_level(LIGHT_SENSE_ENABLE_PIN, false);
         control_mode_set(CONTROL_MODE_SHOW_TIME);
         return true;
     }
 
 
-    adc_val = main_read_current_sensor(false);
+    adc_val = main_get_light_sensor_value();
     display_comp_update_pos(adc_pt, adc_light_value_scale(adc_val) % 60 );
+    display_comp_update_pos(charge_pt, sensor_charge_pos(sensor_light));
 
     return false;
 }
 bool vbatt_sense_mode_tic ( event_flags_t event_flags ) {
     static display_comp_t *adc_pt = NULL;
+    static display_comp_t *charge_pt = NULL;
     uint16_t adc_val;
 
     if (DEFAULT_MODE_TRANS_CHK(event_flags)) {
         if (adc_pt) {
             display_comp_release(adc_pt);
+            display_comp_release(charge_pt);
             adc_pt = NULL;
+            charge_pt = NULL;
         }
         control_mode_set(CONTROL_MODE_SHOW_TIME);
         return true;
@@ -1485,11 +1640,13 @@ bool vbatt_sense_mode_tic ( event_flags_t event_flags ) {
 
     if (!adc_pt) {
         adc_pt = display_point(0, 3);
+        charge_pt = display_point(0, BRIGHT_LOW);
     }
 
 
     display_comp_update_pos(adc_pt,
             adc_vbatt_value_scale(adc_val) % 60);
+    display_comp_update_pos(charge_pt, sensor_charge_pos(sensor_vbatt));
 
 
     return false;
@@ -1791,6 +1948,152 @@ bool tick_counter_mode_tic ( event_flags_t event_flags ) {
 }
 
 
+bool led_charge_mode_tic ( event_flags_t event_flags ) {
+    static display_comp_t *requested_ptr = NULL;
+    static display_comp_t *frame_ptr = NULL;
+    static display_comp_t *limit_ptr = NULL;
+    static animation_t *limited_anim = NULL;
+    const led_charge_stats_t *stats = led_get_charge_stats();
+    uint8_t pos;
+
+    if (DEFAULT_MODE_TRANS_CHK(event_flags)) {
+        anim_release(limited_anim);
+        display_comp_release(requested_ptr);
+        display_comp_release(frame_ptr);
+        display_comp_release(limit_ptr);
+        limited_anim = NULL;
+        requested_ptr = NULL;
+        frame_ptr = NULL;
+        limit_ptr = NULL;
+        control_mode_set(CONTROL_MODE_SHOW_TIME);
+        return true;
+    }
+
+    if (!requested_ptr) {
+        requested_ptr = display_line(0, BRIGHT_LOW, 1);
+        frame_ptr = display_point(0, BRIGHT_DEFAULT);
+        limit_ptr = display_point(0, MAX_BRIGHT_VAL);
+        if (!stats->limit) display_comp_hide(limit_ptr);
+    }
+
+    if (SCLICK(event_flags)) {
+        led_reset_charge_stats();
+        anim_release(limited_anim);
+        limited_anim = NULL;
+        if (stats->limit) display_comp_show(limit_ptr);
+    }
+
+    /* A dim line up to the largest frame asked for, the last frame
+     * shown (this mode's own) and the limit */
+    pos = LED_CHARGE_POS(stats->requested_max, stats->full_led);
+    display_comp_update_length(requested_ptr, pos + 1);
+    display_comp_update_pos(frame_ptr,
+        LED_CHARGE_POS(stats->frame, stats->full_led));
+    display_comp_update_pos(limit_ptr,
+        LED_CHARGE_POS(stats->limit, stats->full_led));
+
+    /* The limit blinks once a frame has been scaled down to it */
+    if (stats->limited_count && !limited_anim) {
+        limited_anim = anim_blink(limit_ptr, BLINK_INT_SLOW,
+            ANIMATION_DURATION_INF, false);
+    }
+
+    return false;
+}
+
+#if (PROFILE)
+void prof_frame_build( uint8_t *frame, prof_section_t section ) {
+    const hist_stats_t *stats = prof_get_stats(section);
+    uint16_t most = 1;
+    uint8_t b;
+
+    for (b = 0; b < HIST_BINS; b++) {
+        if (stats->hist[b] > most) most = stats->hist[b];
+    }
+
+    /* Each bin is brighter the more runs it has.  The off led after
+     * the last bin within a tick (MAIN_TIMER_TICK_US) is lit dim */
+    for (b = 0; b < HIST_BINS; b++) {
+        if (stats->hist[b]) {
+            *frame++ = DISPLAY_FRAME_FILL | (PROF_BIN_LEDS - 1);
+            *frame++ = led_level_to_fine(MIN_BRIGHT_VAL + (uint32_t)
+                stats->hist[b] * (MAX_BRIGHT_VAL - MIN_BRIGHT_VAL) / most);
+        } else {
+            *frame++ = DISPLAY_FRAME_OFF | (PROF_BIN_LEDS - 1);
+        }
+
+        if ((2UL << b) <= MAIN_TIMER_TICK_US * PROF_CYCLES_PER_US &&
+                (4UL << b) > MAIN_TIMER_TICK_US * PROF_CYCLES_PER_US) {
+            *frame++ = DISPLAY_FRAME_FILL | 1;
+            *frame++ = led_level_to_fine(MIN_BRIGHT_VAL);
+        } else {
+            *frame++ = DISPLAY_FRAME_OFF | 1;
+        }
+    }
+
+    *frame = DISPLAY_FRAME_END;
+}
+
+bool prof_mode_tic ( event_flags_t event_flags ) {
+    /* Frames are double buffered as a frame component only
+     * redraws when given a new frame */
+    static uint8_t frames[2][ PROF_FRAME_SIZE ];
+    static display_comp_t *frame_ptr = NULL;
+    static display_comp_t *section_ptr = NULL;
+    static prof_section_t section = PROF_LOOP;
+    static uint32_t section_tic = 0;
+    static uint32_t update_tic = 0;
+    static uint8_t frame_index = 0;
+
+    if (DEFAULT_MODE_TRANS_CHK(event_flags)) {
+        display_comp_release(frame_ptr);
+        display_comp_release(section_ptr);
+        frame_ptr = NULL;
+        section_ptr = NULL;
+        control_mode_set(CONTROL_MODE_SHOW_TIME);
+        return true;
+    }
+
+    if (!frame_ptr) {
+        frame_ptr = display_frame(NULL);
+        section_ptr = display_point(0, BRIGHT_DEFAULT);
+        section_tic = modeticks;
+        update_tic = modeticks - PROF_UPDATE_TICKS;
+    }
+
+    if (SCLICK(event_flags)) {
+        section = section + 1 < PROF_SECTIONS ? section + 1 : PROF_LOOP;
+        section_tic = modeticks;
+    }
+
+    if (TCLICK(event_flags)) {
+        prof_log();
+        section_tic = modeticks;
+    }
+
+    /* Show the section (as a point at 5 * its index) for a
+     * moment before its histogram */
+    if (modeticks - section_tic < PROF_SECTION_SHOW_TICKS) {
+        display_comp_update_pos(section_ptr, section * 5);
+        display_comp_show(section_ptr);
+        display_comp_hide(frame_ptr);
+        return false;
+    }
+
+    display_comp_hide(section_ptr);
+    display_comp_show(frame_ptr);
+
+    if (modeticks - update_tic >= PROF_UPDATE_TICKS) {
+        update_tic = modeticks;
+        frame_index ^= 1;
+        prof_frame_build(frames[frame_index], section);
+        display_comp_update_frame(frame_ptr, frames[frame_index]);
+    }
+
+    return false;
+}
+#endif  /* PROFILE */
+
 bool char_disp_mode_tic ( event_flags_t event_flags ) {
 #define CHARS_PER_UINT32  5UL
 #define MAX_CHARS               45UL
@@ -1920,9 +2223,9 @@ uint8_t control_mode_count( void ) {
   return sizeof(control_modes)/sizeof(ctrl_mode_t);
 }
 
-void control_tic( event_flags_t ev_flags) {
+void control_tic( event_flags_t ev_flags, uint16_t ticks ) {
   ctrl_mode_active->tic_cb(ev_flags);
-  modeticks++;
+  modeticks += ticks;
 }
 
 void control_init( void ) {
@@ -31,6 +31,11 @@ typedef struct {
      * should enter into sleep */
     uint32_t sleep_timeout_ticks;
 
+    /* Longest interval (in ticks) between calls of tic_cb
+     * that the mode can tolerate.  The main timer stretches
+     * its tick up to this when nothing else is due */
+    uint16_t tick_period;
+
 } ctrl_mode_t;
 
 
@@ -67,9 +72,9 @@ uint8_t control_mode_index( ctrl_mode_t* mode_ptr );
    */
 
 
-void control_tic( event_flags_t ev_flags);
+void control_tic( event_flags_t ev_flags, uint16_t ticks );
   /* @brief tic current control mode 
-   * @param event flags
+   * @param event flags, # of ticks elapsed since the previous call
    * @retrn None
    */
 
@@ -8,40 +8,82 @@
   * brightness levels .  On each call to tic(), these
   * components are drawn from tail to head (i.e. the head component
   * takes precedence on any leds modified by lower priority components).
+  * Components are further grouped in layers, drawn bottom (0) to top,
+  * each with a blend mode.
+  * Only leds covered by components that changed (now or before the
+  * change) are redrawn, so tic() does nearly nothing on a still face.
   *
-  * There is a maximum of 64 display components.  Callers should release
-  * their components (via comp_free) when they're not being used (e.g. when
-  * a mode change occurs).
+  * Components come from a fixed pool of MAX_ALLOCATIONS.  Callers should
+  * release their components (via display_comp_release) when they're not
+  * being used (e.g. when a mode change occurs).  If the pool runs out a
+  * shared overflow component, which is never drawn, is handed out instead
+  * and the failure is counted.
+  *
+  * Frame components show a frame of led intensities stored elsewhere
+  * (normally flash).  Frames are run length encoded and decoded as they
+  * are drawn, so they take no more RAM than any other component.
   */
 
 //___ I N C L U D E S ________________________________________________________
 #include "asf/asf.h"
 #include "display.h"
-#include "utlist.h"
 #include "main.h"
+#include "pool.h"
+#include <string.h>
 
 
 //___ M A C R O S   ( P R I V A T E ) ________________________________________
-#define DISP_ERROR_MALLOC_FAIL              ((uint32_t) 1)
 #define DISP_ERROR_DRAW_BAD_TYPE( type )    ((uint32_t) 1<<3)
 #define DISP_ERROR_CLEAR_BAD_TYPE( type )   ((uint32_t) 1<<5) 
+#ifndef MAX_ALLOCATIONS
 #define MAX_ALLOCATIONS     10
-#define MOD(a,b) (((a) % (b)) < 0 ? (((a) % (b)) + (b)) : ((a) % (b)))
-
+#endif
+/* Past this many updates in a tick the whole frame is set at once */
+#define FRAME_UPDATE_MIN    20
+
+/* Bitmaps of the 60 leds -- bit (led % 32) of word (led / 32) */
+#define LED_MAP_WORDS           2
+#define LED_MAP_SET(map, led)   ( (map)[(led) >> 5] |= 1UL << ((led) & 31) )
+#define LED_MAP_TEST(map, led)  ( (map)[(led) >> 5] & (1UL << ((led) & 31)) )
+#define LED_MAP_ANY(map)        ( (map)[0] | (map)[1] )
+#define LED_MAP_CLEAR(map)      ( (map)[0] = (map)[1] = 0 )
+
+/* Components by pool index */
+#define COMP_AT( i )            ( &comp_pool_items[(i)] )
+#define COMP_INDEX( comp )      ( (uint8_t) ((comp) - comp_pool_items) )
+
+/* Each component of the list (index i), in order */
+#define COMP_FOREACH( i, comp )                         \
+  for (i = head_component;                              \
+      i != POOL_NONE && ((comp) = COMP_AT(i), 1);       \
+      i = (comp)->next)
+
+/* Each set led of a bitmap, in index order */
+#define LED_MAP_FOREACH(map, led)               \
+  for (led = led_map_next((map), 0); led < 60;  \
+      led = led_map_next((map), led + 1))
+
+/* Mark an led to be redrawn on the next tic */
 #define LED_OFF(led) \
   do {  \
-    led_levels[(led)] = 0; \
-    leds_updated[updated_led_count++] = led; \
+    LED_MAP_SET(leds_redraw, (led)); \
   } while (0);
 
-
-#define LED_ON(led, intensity) \
+/* Draw an led of the frame being composed (only if being redrawn) */
+#define LED_ON(layer, led, intensity) \
   do {  \
-    led_levels[(led)] = intensity; \
-    leds_updated[updated_led_count++] = led; \
+    if (LED_MAP_TEST(leds_redraw, (led))) \
+      frame_levels[(led)] = layer_blend((layer), frame_levels[(led)], intensity); \
   } while (0);
 
 //___ T Y P E D E F S   ( P R I V A T E ) ____________________________________
+typedef struct display_layer_t {
+  display_blend_t blend;
+  bool dirty;       // changed since last drawn
+} display_layer_t;
+
+/* Components are kept to 8 bytes (see the pool report at link time) */
+typedef char display_comp_size_check[ sizeof(display_comp_t) == 8 ? 1 : -1 ];
 
 //___ P R O T O T Y P E S   ( P R I V A T E ) ________________________________
 
@@ -49,7 +91,13 @@
 display_comp_t* comp_alloc ( void );
   /* @brief allocate a new display component
    * @param None
-   * @retrn the new component
+   * @retrn the new component (the overflow component if none are left)
+   */
+
+void comp_add ( display_comp_t* ptr );
+  /* @brief add a new component to the list of those drawn
+   * @param pointer to comp to add (ignored for the overflow component)
+   * @retrn None
    */
 
 void comp_free ( display_comp_t* ptr );
@@ -59,15 +107,71 @@ void comp_free ( display_comp_t* ptr );
    */
 
 void comp_leds_clear( display_comp_t *comp );
-  /* @brief turn off leds corresponding to given component
+  /* @brief mark the leds covered by the given component for redraw.
+   *   They are turned off unless another component draws them
    * @param component to clear
    * @retrn None
    */
 
+uint8_t comp_level_fine( uint8_t level, uint8_t frac );
+  /* @brief fine led intensity for a fractional brightness level
+   * @param brightness level, fraction (1/256) to the next level
+   * @retrn fine intensity
+   */
+
+static inline uint8_t layer_blend( const display_layer_t *layer,
+    uint8_t below, uint8_t fine );
+  /* @brief blend an led drawn on a layer with what is below it
+   * @param layer, level below, fine intensity drawn
+   * @retrn resulting fine intensity
+   */
+
+uint8_t led_map_next( const uint32_t map[], uint8_t led );
+  /* @brief find the next led set in a bitmap
+   * @param bitmap, led to start from
+   * @retrn first set led at or after the given one, 60 if none
+   */
+
+void led_map_set_range( uint32_t map[], uint8_t first, uint8_t count );
+  /* @brief set a range of leds in a bitmap, wrapping from 59 to 0
+   * @param bitmap, first led, # of leds (up to 60)
+   * @retrn None
+   */
+
+uint8_t comp_span( const display_comp_t *comp, uint8_t *first );
+  /* @brief leds covered by a point, line or snake as a clockwise range
+   * @param component, set to the first led of the range
+   * @retrn # of leds in the range (1 to 60)
+   */
+
+void polygon_map_set( const display_comp_t *comp, uint32_t map[] );
+  /* @brief set the vertices of a polygon in a bitmap
+   * @param polygon component, bitmap
+   * @retrn None
+   */
+
+const uint8_t * comp_frame( const display_comp_t *comp );
+  /* @brief the frame shown by a frame component
+   * @param frame component
+   * @retrn frame (see display_frame) or NULL for none
+   */
+
+void frame_map_set( const display_comp_t *comp, uint32_t map[] );
+  /* @brief set the leds a frame component lights in a bitmap
+   * @param frame component, bitmap
+   * @retrn None
+   */
+
+void frame_draw( const display_comp_t *comp, const display_layer_t *layer );
+  /* @brief draw a frame component, decoding its frame
+   * @param frame component, its layer
+   * @retrn None
+   */
+
 void comp_draw( display_comp_t* comp_ptr);
-  /* @brief draws the given component to the display
+  /* @brief draws the given component to the frame being composed
    *    (i.e. sets the led state(s) comprising the
-   *    component)
+   *    component).  Only leds being redrawn are written
    * @param component to draw
    * @retrn None
    */
@@ -76,14 +180,36 @@ void comp_draw( display_comp_t* comp_ptr);
 
 //___ V A R I A B L E S ______________________________________________________
 
+/* Polygon vertex spacing by # of sides n: 60/n leds plus 60%n / n,
+ * so vertices are placed without dividing */
+static const struct {
+  uint8_t step;
+  uint8_t rem;
+} POLYGON_STEPS[ 61 ] = {
+  { 0, 0}, {60, 0}, {30, 0}, {20, 0}, {15, 0}, {12, 0}, {10, 0}, { 8, 4},
+  { 7, 4}, { 6, 6}, { 6, 0}, { 5, 5}, { 5, 0}, { 4, 8}, { 4, 4}, { 4, 0},
+  { 3,12}, { 3, 9}, { 3, 6}, { 3, 3}, { 3, 0}, { 2,18}, { 2,16}, { 2,14},
+  { 2,12}, { 2,10}, { 2, 8}, { 2, 6}, { 2, 4}, { 2, 2}, { 2, 0}, { 1,29},
+  { 1,28}, { 1,27}, { 1,26}, { 1,25}, { 1,24}, { 1,23}, { 1,22}, { 1,21},
+  { 1,20}, { 1,19}, { 1,18}, { 1,17}, { 1,16}, { 1,15}, { 1,14}, { 1,13},
+  { 1,12}, { 1,11}, { 1,10}, { 1, 9}, { 1, 8}, { 1, 7}, { 1, 6}, { 1, 5},
+  { 1, 4}, { 1, 3}, { 1, 2}, { 1, 1}, { 1, 0},
+};
+
 /* statically allocate maximum number of display components */
-static display_comp_t component_allocs[MAX_ALLOCATIONS];
-static uint8_t led_levels[60] = {0x00};
-static uint8_t leds_updated[60] = {0xff};
+POOL_DECLARE(comp_pool, display_comp_t, MAX_ALLOCATIONS);
+static display_comp_t overflow_comp;  /* handed out when the pool is empty */
+/* frame of each frame component, by pool index */
+static const uint8_t *comp_frames[MAX_ALLOCATIONS];
+static uint8_t led_levels[60] = {0x00}; /* fine intensities shown */
+static uint8_t frame_levels[60];        /* frame being composed */
+static display_layer_t layers[DISPLAY_LAYER_COUNT];
+static uint32_t leds_redraw[LED_MAP_WORDS];   /* led may change this tic */
+static uint32_t leds_updated[LED_MAP_WORDS];  /* level changed this tic */
 static uint8_t updated_led_count = 0;
 
-/* pointer to head of active component list */
-static display_comp_t *head_component_ptr = NULL;
+/* index of head of active component list */
+static uint8_t head_component = POOL_NONE;
 
 
 //___ I N T E R R U P T S  ___________________________________________________
@@ -91,88 +217,283 @@ static display_comp_t *head_component_ptr = NULL;
 //___ F U N C T I O N S   ( P R I V A T E ) __________________________________
 
 display_comp_t *comp_alloc( void ) {
-  uint8_t i;
+  return display_comp_at(pool_alloc(&comp_pool));
+}
 
-  for (i=0; i < MAX_ALLOCATIONS; i++) {
-    if (component_allocs[i].type == dispt_unused)
-      return component_allocs + i;
-  }
+void comp_add ( display_comp_t* ptr ) {
+  if (ptr == &overflow_comp) return;
 
-  main_terminate_in_error( error_group_disp, DISP_ERROR_MALLOC_FAIL );
-  return NULL;
+  pool_list_append(&comp_pool, &head_component, COMP_INDEX(ptr));
 }
 
 void comp_free ( display_comp_t* ptr ) {
+  if (ptr == &overflow_comp || ptr->type == dispt_unused) return;
+
   ptr->type = dispt_unused;
+  pool_free(&comp_pool, COMP_INDEX(ptr));
+}
+
+uint8_t comp_level_fine( uint8_t level, uint8_t frac ) {
+  uint8_t fine = led_level_to_fine(level);
+
+  if (frac && level < MAX_BRIGHT_VAL) {
+    fine += ((uint16_t) (LED_LEVEL_FINE[level + 1] - fine) * frac) >> 8;
+  }
+
+  return fine;
+}
+
+static inline uint8_t layer_blend( const display_layer_t *layer,
+    uint8_t below, uint8_t fine ) {
+  uint16_t sum;
+
+  switch (layer->blend) {
+    case display_blend_max:
+      return fine > below ? fine : below;
+    case display_blend_add:
+      sum = below + fine;
+      return sum > LED_FINE_MAX ? LED_FINE_MAX : sum;
+    case display_blend_replace:
+    default:
+      return fine;
+  }
+}
+
+uint8_t led_map_next( const uint32_t map[], uint8_t led ) {
+  uint32_t word;
+
+  while (led < 60) {
+    word = map[led >> 5] >> (led & 31);
+    if (!word) {
+      /* rest of this word is clear */
+      led = (led | 31) + 1;
+      continue;
+    }
+
+    while (!(word & 0xff)) {
+      word >>= 8;
+      led += 8;
+    }
+    while (!(word & 1)) {
+      word >>= 1;
+      led++;
+    }
+    return led;
+  }
+
+  return 60;
+}
+
+void led_map_set_range( uint32_t map[], uint8_t first, uint8_t count ) {
+  uint8_t bit, n;
+
+  while (count) {
+    /* up to the end of this word or the ring, whichever is first */
+    bit = first & 31;
+    n = 32 - bit;
+    if (n > 60 - first) n = 60 - first;
+    if (n > count) n = count;
+
+    map[first >> 5] |= (n == 32 ? 0xffffffff : (1UL << n) - 1) << bit;
+
+    count -= n;
+    first += n;
+    if (first == 60) first = 0;
+  }
+}
+
+uint8_t comp_span( const display_comp_t *comp, uint8_t *first ) {
+  int16_t pos = comp->pos;
+  uint8_t count = 1;
+
+  if (comp->type != dispt_point) {
+    count = comp->length < 1 || comp->length > 60 ? 60 : comp->length;
+    if (!comp->cw) pos -= count - 1;
+  }
+
+  while (pos < 0) pos += 60;
+  while (pos >= 60) pos -= 60;
+
+  *first = pos;
+  return count;
+}
+
+void polygon_map_set( const display_comp_t *comp, uint32_t map[] ) {
+  uint8_t sides = comp->length < 1 || comp->length > 60 ? 60 : comp->length;
+  uint8_t step = POLYGON_STEPS[sides].step;
+  uint8_t rem = POLYGON_STEPS[sides].rem;
+  int16_t pos = comp->pos;
+  uint8_t i, acc = 0;
+
+  while (pos < 0) pos += 60;
+  while (pos >= 60) pos -= 60;
+
+  /* vertex i is at pos + floor(i*60/sides) */
+  for (i = 0; i < sides; i++) {
+    LED_MAP_SET(map, pos);
+
+    pos += step;
+    acc += rem;
+    if (acc >= sides) {
+      acc -= sides;
+      pos++;
+    }
+    if (pos >= 60) pos -= 60;
+  }
+}
+
+const uint8_t * comp_frame( const display_comp_t *comp ) {
+  return comp == &overflow_comp ? NULL : comp_frames[COMP_INDEX(comp)];
+}
+
+void frame_map_set( const display_comp_t *comp, uint32_t map[] ) {
+  const uint8_t *frame = comp_frame(comp);
+  uint8_t run, count, led = 0;
+
+  if (!frame) return;
+
+  while ((run = *frame++) != DISPLAY_FRAME_END && led < 60) {
+    count = run & DISPLAY_FRAME_RUN_MAX;
+    if (count > 60 - led) count = 60 - led;
+
+    switch (run & ~DISPLAY_FRAME_RUN_MAX) {
+      case DISPLAY_FRAME_FILL:
+        frame++;
+        led_map_set_range(map, led, count);
+        break;
+      case DISPLAY_FRAME_COPY:
+        frame += run & DISPLAY_FRAME_RUN_MAX;
+        led_map_set_range(map, led, count);
+        break;
+      case DISPLAY_FRAME_OFF:
+      default:
+        break;
+    }
+    led += count;
+  }
+}
+
+void frame_draw( const display_comp_t *comp, const display_layer_t *layer ) {
+  const uint8_t *frame = comp_frame(comp);
+  uint8_t run, kind, count, level, led = 0;
+
+  if (!frame) return;
+
+  /* Straight from the encoded frame, so nothing is buffered */
+  while ((run = *frame++) != DISPLAY_FRAME_END && led < 60) {
+    kind = run & ~DISPLAY_FRAME_RUN_MAX;
+    count = run & DISPLAY_FRAME_RUN_MAX;
+    if (count > 60 - led) count = 60 - led;
+
+    if (kind != DISPLAY_FRAME_FILL && kind != DISPLAY_FRAME_COPY) {
+      led += count;
+      continue;
+    }
+
+    while (count--) {
+      level = kind == DISPLAY_FRAME_FILL ? *frame : *frame++;
+      /* A hidden component still blanks the leds it covers */
+      LED_ON(layer, led, comp->on ? level : 0);
+      led++;
+    }
+
+    if (kind == DISPLAY_FRAME_FILL) frame++;
+  }
 }
 
 void comp_draw( display_comp_t* comp) {
-  int32_t tmp, pos;
+  const display_layer_t *layer = &layers[comp->layer];
   uint8_t bright = comp->brightness;
+  uint8_t fine = comp_level_fine(comp->brightness, comp->brightness_frac);
+  uint8_t frac = comp->pos_frac;
+  uint8_t vals[60];
+  uint32_t covered[LED_MAP_WORDS] = { 0, 0 };
+  uint8_t led, prev, count, i, dist;
+  uint16_t level;
+
+  /* A hidden component still blanks the leds it covers */
   if (!comp->on) {
-    comp_leds_clear(comp);
-    return;
+    fine = 0;
+    bright = MIN_BRIGHT_VAL;
   }
 
+  /* Points, lines and snakes are drawn to a local copy first so they
+   * can be moved by a fraction of an led */
   switch(comp->type) {
     case dispt_point:
-      LED_ON(comp->pos, comp->brightness);
-      break;
     case dispt_snake:
     case dispt_line:
-      pos = comp->cw ? MOD(comp->pos + comp->length - 1, 60) : \
-            MOD(comp->pos - comp->length + 1, 60);
-      do {
-        LED_ON(pos, bright);
-        if (pos == comp->pos) return;
-
-        pos = comp->cw ? MOD(pos - 1, 60) : MOD(pos + 1, 60);
-        if (comp->type == dispt_snake &&
-            bright > MIN_BRIGHT_VAL)
-          bright--;
-
-      } while (true);
-
+      count = comp_span(comp, &led);
+      led_map_set_range(covered, led, count);
+
+      for (i = 0; i < count; i++) {
+        /* snakes fade by a level per led from their head (the far
+         * end from pos) down to the minimum */
+        if (comp->type == dispt_snake && bright > MIN_BRIGHT_VAL) {
+          dist = comp->cw ? count - 1 - i : i;
+          level = bright - MIN_BRIGHT_VAL > dist ? bright - dist :
+            MIN_BRIGHT_VAL;
+          fine = comp_level_fine(level, comp->brightness_frac);
+        }
+
+        vals[led] = fine;
+        if (++led == 60) led = 0;
+      }
       break;
     case dispt_polygon:
-      for (tmp = 0; tmp < comp->length; tmp++) {
-        pos = (comp->pos + ((tmp*60)/comp->length)) % 60;
-        LED_ON(pos, comp->brightness);
+      polygon_map_set(comp, covered);
+      LED_MAP_FOREACH(covered, led) {
+        LED_ON(layer, led, fine);
       }
-      break;
+      return;
+    case dispt_frame:
+      frame_draw(comp, layer);
+      return;
     default:
       main_terminate_in_error( error_group_disp,
           DISP_ERROR_DRAW_BAD_TYPE( comp->type ) );
-      break;
+      return;
+  }
+
+  if (!frac) {
+    LED_MAP_FOREACH(covered, led) {
+      LED_ON(layer, led, vals[led]);
+    }
+    return;
+  }
+
+  /* In between leds: each led takes (1 - frac) of its own level and
+   * frac of the one before it */
+  for (led = 0; led < 60; led++) {
+    prev = led ? led - 1 : 59;
+    if (!LED_MAP_TEST(covered, led) && !LED_MAP_TEST(covered, prev)) continue;
+
+    level = 0;
+    if (LED_MAP_TEST(covered, led)) level += vals[led] * (256 - frac);
+    if (LED_MAP_TEST(covered, prev)) level += vals[prev] * frac;
+    LED_ON(layer, led, level >> 8);
   }
 }
 
 
 void comp_leds_clear(  display_comp_t *comp ) {
-  int32_t tmp, pos, pos_end;
+  uint8_t first, count;
+
   switch(comp->type) {
     case dispt_point:
-      LED_OFF(comp->pos);
-      break;
     case dispt_snake:
     case dispt_line:
+      /* In between leds also covers the next led */
+      count = comp_span(comp, &first);
+      if (comp->pos_frac && count < 60) count++;
 
-      pos = MOD(comp->pos, 60);
-      pos_end = comp->cw ? MOD(comp->pos + comp->length, 60) : \
-                MOD(comp->pos - comp->length, 60);
-      do {
-
-        LED_OFF(pos);
-        pos = comp->cw ? MOD(pos + 1, 60) : MOD(pos - 1, 60);
-
-      } while (pos != pos_end);
-
+      led_map_set_range(leds_redraw, first, count);
       break;
     case dispt_polygon:
-      for (tmp = 0; tmp < comp->length; tmp++) {
-        pos = comp->pos + ((tmp*60)/comp->length);
-        LED_OFF(pos % 60);
-      }
+      polygon_map_set(comp, leds_redraw);
+      break;
+    case dispt_frame:
+      frame_map_set(comp, leds_redraw);
       break;
     default:
       main_terminate_in_error( error_group_disp,
@@ -190,13 +511,15 @@ display_comp_t* display_point ( int8_t pos,
 
   comp_ptr->type = dispt_point;
   comp_ptr->on = true;
+  comp_ptr->dirty = true;
+  comp_ptr->layer = 0;
   comp_ptr->brightness = brightness;
+  comp_ptr->brightness_frac = 0;
   comp_ptr->pos = pos;
+  comp_ptr->pos_frac = 0;
   comp_ptr->length = 1;
 
-  comp_ptr->next = comp_ptr->prev = NULL;
-
-  DL_APPEND(head_component_ptr, comp_ptr);
+  comp_add(comp_ptr);
 
   return comp_ptr;
 
@@ -209,14 +532,16 @@ display_comp_t* display_line ( int8_t pos,
 
   comp_ptr->type = dispt_line;
   comp_ptr->on = true;
+  comp_ptr->dirty = true;
+  comp_ptr->layer = 0;
   comp_ptr->brightness = brightness;
+  comp_ptr->brightness_frac = 0;
   comp_ptr->pos = pos;
+  comp_ptr->pos_frac = 0;
   comp_ptr->length = length;
   comp_ptr->cw = true;
 
-  comp_ptr->next = comp_ptr->prev = NULL;
-
-  DL_APPEND(head_component_ptr, comp_ptr);
+  comp_add(comp_ptr);
 
   return comp_ptr;
 }
@@ -228,14 +553,16 @@ display_comp_t* display_snake ( int8_t pos,
 
   comp_ptr->type = dispt_snake;
   comp_ptr->on = true;
+  comp_ptr->dirty = true;
+  comp_ptr->layer = 0;
   comp_ptr->brightness = brightness;
+  comp_ptr->brightness_frac = 0;
   comp_ptr->pos = pos;
+  comp_ptr->pos_frac = 0;
   comp_ptr->length = length;
   comp_ptr->cw = clockwise;
 
-  comp_ptr->next = comp_ptr->prev = NULL;
-
-  DL_APPEND(head_component_ptr, comp_ptr);
+  comp_add(comp_ptr);
 
   return comp_ptr;
 }
@@ -248,29 +575,74 @@ display_comp_t* display_polygon ( int8_t pos,
 
   comp_ptr->type = dispt_polygon;
   comp_ptr->on = true;
+  comp_ptr->dirty = true;
+  comp_ptr->layer = 0;
   comp_ptr->brightness = brightness;
+  comp_ptr->brightness_frac = 0;
   comp_ptr->pos = pos;
+  comp_ptr->pos_frac = 0;
   comp_ptr->length = num_sides;
 
-  comp_ptr->next = comp_ptr->prev = NULL;
+  comp_add(comp_ptr);
+
+  return comp_ptr;
+}
 
-  DL_APPEND(head_component_ptr, comp_ptr);
+display_comp_t* display_frame ( const uint8_t *frame ) {
+
+  display_comp_t *comp_ptr = comp_alloc();
+
+  comp_ptr->type = dispt_frame;
+  comp_ptr->on = true;
+  comp_ptr->dirty = true;
+  comp_ptr->layer = 0;
+  comp_ptr->brightness = 0;
+  comp_ptr->brightness_frac = 0;
+  comp_ptr->pos = 0;
+  comp_ptr->pos_frac = 0;
+  comp_ptr->length = 60;
+
+  if (comp_ptr != &overflow_comp) {
+    comp_frames[COMP_INDEX(comp_ptr)] = frame;
+  }
+
+  comp_add(comp_ptr);
 
   return comp_ptr;
 }
 
 void display_comp_hide (display_comp_t *comp) {
+  if (!comp->on) return;
   comp->on = false;
-  comp_leds_clear(comp);
+  comp->dirty = true;
+}
+
+void display_comp_set_layer ( display_comp_t *comp, uint8_t layer ) {
+  if (layer >= DISPLAY_LAYER_COUNT) layer = DISPLAY_LAYER_COUNT - 1;
+  if (comp->layer == layer) return;
+
+  comp->layer = layer;
+  comp->dirty = true;
+}
+
+void display_layer_set_blend ( uint8_t layer, display_blend_t blend ) {
+  if (layer >= DISPLAY_LAYER_COUNT || layers[layer].blend == blend) return;
+
+  layers[layer].blend = blend;
+  layers[layer].dirty = true;
 }
 
 void display_comp_hide_all ( void ) {
   display_comp_t* comp_ptr;
+  uint8_t i;
 
-  DL_FOREACH(head_component_ptr, comp_ptr) {
+  COMP_FOREACH(i, comp_ptr) {
     comp_ptr->on = false;
+    comp_ptr->dirty = true;
   }
 
+  /* keep the cache in step so a full frame update stays clear */
+  memset(led_levels, 0, sizeof(led_levels));
   led_clear_all();
 
 }
@@ -278,19 +650,30 @@ void display_comp_hide_all ( void ) {
 
 void display_comp_show_all ( void ) {
   display_comp_t* comp_ptr;
+  uint8_t i;
 
-  DL_FOREACH(head_component_ptr, comp_ptr) {
-    comp_ptr->on = true;
+  COMP_FOREACH(i, comp_ptr) {
+    display_comp_show(comp_ptr);
   }
 
 }
 
 void display_comp_update_pos ( display_comp_t *comp, int8_t pos ) {
-  if (pos == comp->pos)
+  display_comp_update_pos_frac(comp, pos, 0);
+}
+
+void display_comp_update_pos_frac ( display_comp_t *comp, int8_t pos,
+    uint8_t frac ) {
+  if (comp->type == dispt_polygon)
+    frac = 0;
+
+  if (pos == comp->pos && frac == comp->pos_frac)
     return;
 
   comp_leds_clear(comp);
   comp->pos = pos;
+  comp->pos_frac = frac;
+  comp->dirty = true;
 
 }
 
@@ -304,13 +687,50 @@ void display_comp_update_length ( display_comp_t *comp, int8_t length ) {
 
   comp_leds_clear(comp);
   comp->length = length;
+  comp->dirty = true;
+
+}
+
+void display_comp_update_frame ( display_comp_t *comp,
+    const uint8_t *frame ) {
+
+  if (comp->type != dispt_frame || comp == &overflow_comp)
+    return;
+
+  if (comp_frames[COMP_INDEX(comp)] == frame)
+    return;
+
+  comp_leds_clear(comp);
+  comp_frames[COMP_INDEX(comp)] = frame;
+  comp->dirty = true;
+
+}
+
+const uint8_t * display_frame_end ( const uint8_t *frame ) {
+  uint8_t run;
+
+  while ((run = *frame++) != DISPLAY_FRAME_END) {
+    switch (run & ~DISPLAY_FRAME_RUN_MAX) {
+      case DISPLAY_FRAME_FILL:
+        frame++;
+        break;
+      case DISPLAY_FRAME_COPY:
+        frame += run & DISPLAY_FRAME_RUN_MAX;
+        break;
+      default:
+        break;
+    }
+  }
 
+  return frame;
 }
 
 void display_relative( display_comp_t* line_ptr, uint8_t origin,
     int8_t value) {
 
   comp_leds_clear(line_ptr);
+  line_ptr->dirty = true;
+  line_ptr->pos_frac = 0;
   if (value >= 0) {
     line_ptr->length = value + 1;
     line_ptr->pos = (origin + value) % 60;
@@ -323,40 +743,104 @@ void display_relative( display_comp_t* line_ptr, uint8_t origin,
 }
 
 void display_comp_release (display_comp_t *comp_ptr) {
-  if (!comp_ptr) return;
+  if (!comp_ptr || comp_ptr == &overflow_comp) return;
   comp_leds_clear(comp_ptr);
-  DL_DELETE(head_component_ptr, comp_ptr);
+  pool_list_delete(&comp_pool, &head_component, COMP_INDEX(comp_ptr));
   comp_free(comp_ptr);
 }
 
 void display_refresh(void) {
-
+  /* The leds may have been changed behind our back (e.g. cleared on
+   * wake) so redraw all of them */
+  memset(led_levels, 0, sizeof(led_levels));
+  leds_redraw[0] = 0xffffffff;
+  leds_redraw[1] = 0x0fffffff;
 }
 
 void display_tic(void) {
   display_comp_t* comp_ptr;
+  uint8_t i, led, layer;
+
+  /* Changed components (or those on a changed layer) are redrawn
+   * where they are now.  Where they were before the change was
+   * marked when it happened */
+  COMP_FOREACH(i, comp_ptr) {
+    if (comp_ptr->dirty || layers[comp_ptr->layer].dirty) {
+      comp_leds_clear(comp_ptr);
+      comp_ptr->dirty = false;
+    }
+  }
+
+  for (layer = 0; layer < DISPLAY_LAYER_COUNT; layer++) {
+    layers[layer].dirty = false;
+  }
+
+  if (!LED_MAP_ANY(leds_redraw)) {
+    /* still show back buffer changes made outside the compositor (e.g.
+     * led_set_max_brightness) -- a no-op when there are none */
+    led_commit();
+    return;
+  }
 
-  DL_FOREACH(head_component_ptr, comp_ptr) {
-    comp_draw(comp_ptr);
+  LED_MAP_FOREACH(leds_redraw, led) {
+    frame_levels[led] = 0;
+  }
+
+  /* Every component is drawn once, bottom layer first and in list
+   * order within a layer, but only leds marked for redraw are written */
+  for (layer = 0; layer < DISPLAY_LAYER_COUNT; layer++) {
+    COMP_FOREACH(i, comp_ptr) {
+      if (comp_ptr->layer == layer) comp_draw(comp_ptr);
+    }
   }
 
   /* The draw/clear functions dont actually update
    * the leds directly.  Instead they write to a
-   * local cache that we update as a batch.  This prevents
-   * conflicts when multiple display components update the same led.
+   * local cache that we update as a batch, pushing only
+   * leds whose level changed.
    */
+  LED_MAP_FOREACH(leds_redraw, led) {
+    if (frame_levels[led] != led_levels[led]) {
+      led_levels[led] = frame_levels[led];
+      LED_MAP_SET(leds_updated, led);
+      updated_led_count++;
+    }
+  }
+  LED_MAP_CLEAR(leds_redraw);
 
-  while (updated_led_count) {
-    uint8_t led = leds_updated[updated_led_count - 1];
-    led_set_intensity( led, led_levels[led] );
-    updated_led_count--;
+  /* Each changed led is pushed once, in index order */
+  if (updated_led_count >= FRAME_UPDATE_MIN) {
+    led_set_frame( led_levels );
+  } else {
+    LED_MAP_FOREACH(leds_updated, led) {
+      led_set_intensity_fine( led, led_levels[led] );
+    }
   }
+  LED_MAP_CLEAR(leds_updated);
+  updated_led_count = 0;
+
+  /* show the whole batch at once */
+  led_commit();
+}
+
+display_comp_t * display_comp_at( uint8_t index ) {
+  return index == POOL_NONE ? &overflow_comp : COMP_AT(index);
+}
+
+uint8_t display_comp_index( const display_comp_t *ptr ) {
+  return ptr == &overflow_comp ? POOL_NONE : COMP_INDEX(ptr);
+}
+
+const pool_t * display_get_pool( void ) {
+  return &comp_pool;
 }
 
 void display_init(void) {
   int i;
-  for (i=0; i < MAX_ALLOCATIONS; i++) {
-    component_allocs[i].type = dispt_unused;
+
+  for (i=0; i < DISPLAY_LAYER_COUNT; i++) {
+    layers[i].blend = display_blend_replace;
+    layers[i].dirty = false;
   }
 }
 
@@ -15,30 +15,52 @@
 //___ I N C L U D E S ________________________________________________________
 #include <asf.h>
 #include "leds.h"
+#include "pool.h"
 
 //___ M A C R O S ____________________________________________________________
+#define DISPLAY_LAYER_COUNT         4   /* at most 4 (2-bit comp field) */
+
+/* Frames (see display_frame) are runs of fine intensities from led 0
+ * clockwise.  Each run starts with a byte of its kind or'd with its
+ * # of leds (1 to DISPLAY_FRAME_RUN_MAX).  Leds past the last run are off.
+ * Kind 0xc0 is reserved (leds off) */
+#define DISPLAY_FRAME_OFF           0x00  /* leds off */
+#define DISPLAY_FRAME_FILL          0x40  /* leds at the level in the next byte */
+#define DISPLAY_FRAME_COPY          0x80  /* leds at the levels in the next bytes */
+#define DISPLAY_FRAME_END           0x00  /* (0 leds off) ends a frame */
+#define DISPLAY_FRAME_RUN_MAX       0x3f
 
 //___ T Y P E D E F S ________________________________________________________
 
+/* How a layer's leds combine with the layers below */
+typedef enum {
+  display_blend_replace = 0,  // drawn leds replace those below (default)
+  display_blend_max,          // the brighter of the two
+  display_blend_add           // sum, saturating at full brightness
+} display_blend_t;
+
 typedef enum {
   dispt_unused = 0,
   dispt_point,
   dispt_line,
   dispt_snake,
-  dispt_polygon
+  dispt_polygon,
+  dispt_frame
 } display_type_t;
 
 typedef struct display_comp_t {
-  bool on;
-  display_type_t type;
+  uint8_t type : 3; //display_type_t
+  bool on : 1;
+  bool dirty : 1; //changed since last drawn
+  bool cw : 1; //clockwise -- only applicable to snakes for now
+  uint8_t layer : 2; //0 (bottom, default) to DISPLAY_LAYER_COUNT - 1
 
   uint8_t brightness;
+  uint8_t brightness_frac; //fraction (1/256) of the way to the next level
   int8_t pos;
+  uint8_t pos_frac; //fraction (1/256) of the way to pos + 1 (not for polygons)
   int8_t length;
-  bool cw; //clockwise -- only applicable to snakes for now
-  struct display_comp_t *next, *prev;
-
-
+  uint8_t next, prev; //component pool indices (see pool.h)
 } display_comp_t;
 
 //___ V A R I A B L E S ______________________________________________________
@@ -100,6 +122,14 @@ display_comp_t* display_polygon ( int8_t pos,
    *   the polygon being displayed
    */
 
+display_comp_t* display_frame ( const uint8_t *frame );
+  /* @brief display a frame of led intensities (e.g. one of a sequence
+   *    in flash), decoded as it is drawn so it takes no RAM
+   * @param frame - runs of fine intensities (see DISPLAY_FRAME_*), not
+   *    copied so must stay valid.  NULL for none
+   * @retrn handle to a display structure representing the
+   *   frame being displayed.  Its brightness is unused
+   */
 
 void display_comp_update_pos ( display_comp_t *ptr, int8_t pos );
   /* @brief update the pos position of the given component
@@ -108,6 +138,16 @@ void display_comp_update_pos ( display_comp_t *ptr, int8_t pos );
    * @retrn None
    */
 
+void display_comp_update_pos_frac ( display_comp_t *ptr, int8_t pos,
+        uint8_t frac );
+  /* @brief update the position of the given component to in between
+   *    two leds (anti-aliased).  Polygons stay on whole leds
+   * @param comp_ptr - handle to component to update
+   * @param new_pos - new position for component
+   * @param frac - fraction (1/256) of the way to new_pos + 1
+   * @retrn None
+   */
+
 void display_comp_update_length ( display_comp_t *ptr, int8_t length );
   /* @brief update the length (if applicable) of the given component
    * @param comp_ptr - handle to component to update
@@ -115,6 +155,20 @@ void display_comp_update_length ( display_comp_t *ptr, int8_t length );
    * @retrn None
    */
 
+void display_comp_update_frame ( display_comp_t *ptr,
+        const uint8_t *frame );
+  /* @brief change the frame shown by a frame component
+   * @param comp_ptr - handle to component to update
+   * @param frame - new frame (see display_frame)
+   * @retrn None
+   */
+
+const uint8_t * display_frame_end ( const uint8_t *frame );
+  /* @brief find the end of a frame, e.g. to step through a sequence
+   * @param frame (see display_frame)
+   * @retrn the byte after the frame's DISPLAY_FRAME_END
+   */
+
 void display_relative( display_comp_t* line_ptr, uint8_t origin,
         int8_t value);
   /* @brief draw line ending at the given value relative to the
@@ -125,7 +179,10 @@ void display_relative( display_comp_t* line_ptr, uint8_t origin,
 
 static inline void display_comp_update_brightness ( display_comp_t *ptr,
         uint8_t intensity) {
+    if (ptr->brightness == intensity && !ptr->brightness_frac) return;
     ptr->brightness = intensity;
+    ptr->brightness_frac = 0;
+    ptr->dirty = true;
 }
   /* @brief update the brightness for this display component
    * @param comp_ptr - handle to component to update
@@ -133,6 +190,21 @@ static inline void display_comp_update_brightness ( display_comp_t *ptr,
    * @retrn None
    */
 
+static inline void display_comp_update_brightness_frac ( display_comp_t *ptr,
+        uint8_t intensity, uint8_t frac) {
+    if (ptr->brightness == intensity && ptr->brightness_frac == frac) return;
+    ptr->brightness = intensity;
+    ptr->brightness_frac = frac;
+    ptr->dirty = true;
+}
+  /* @brief update the brightness for this display component to a
+   *    level in between brightness levels (for smooth fades)
+   * @param comp_ptr - handle to component to update
+   * @param intensity - new brightness
+   * @param frac - fraction (1/256) of the way to the next level
+   * @retrn None
+   */
+
 
 void display_comp_hide (display_comp_t *ptr);
   /* @brief hide the given component from displaying
@@ -150,12 +222,30 @@ void display_comp_show_all ( void );
    * @retrn None
    */
 
-static inline void display_comp_show (display_comp_t *ptr) { ptr->on = true; }
+static inline void display_comp_show (display_comp_t *ptr) {
+    if (ptr->on) return;
+    ptr->on = true;
+    ptr->dirty = true;
+}
   /* @brief show a previously hidden display component
    * @param component handle to show
    * @retrn None
    */
 
+void display_comp_set_layer ( display_comp_t *ptr, uint8_t layer );
+  /* @brief move a component to another layer
+   * @param comp_ptr - handle to component to update
+   * @param layer - 0 (bottom) to DISPLAY_LAYER_COUNT - 1
+   * @retrn None
+   */
+
+void display_layer_set_blend ( uint8_t layer, display_blend_t blend );
+  /* @brief set how a layer combines with the layers below it
+   * @param layer - 0 (bottom) to DISPLAY_LAYER_COUNT - 1
+   * @param blend - blend mode
+   * @retrn None
+   */
+
 void display_comp_release (display_comp_t *comp_ptr);
   /* @brief clear the given component from the display.  the
    *   component handle will no longer be valid for caller
@@ -164,11 +254,30 @@ void display_comp_release (display_comp_t *comp_ptr);
    */
 
 void display_refresh(void);
-  /* @brief refresh display
+  /* @brief redraw every led on the next tic (after the leds were
+   *   changed outside the display, e.g. led_clear_all)
    * @param None
    * @retrn None
    */
 
+display_comp_t * display_comp_at( uint8_t index );
+  /* @brief find a component by its index
+   * @param index (POOL_NONE for the overflow component)
+   * @retrn component
+   */
+
+uint8_t display_comp_index( const display_comp_t *ptr );
+  /* @brief index of a component, e.g. to refer to it in a compact record
+   * @param component
+   * @retrn index (POOL_NONE for the overflow component)
+   */
+
+const pool_t * display_get_pool( void );
+  /* @brief display component pool usage (high water mark, failures)
+   * @param None
+   * @retrn component pool
+   */
+
 
 #endif /* end of include guard */
 
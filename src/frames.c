@@ -0,0 +1,19 @@
+/* generated by scripts/frames2anim.py -- do not edit */
+
+#include "frames.h"
+
+/* graphics/frames/heartbeat.txt */
+const uint8_t FRAMES_HEARTBEAT[126] = {
+  0x50, 0x00, 0x81, 0xff, 0x4e, 0x28, 0x81, 0xff, 0x4e, 0x28, 0x81, 0xff,
+  0x4e, 0x28, 0x81, 0xff, 0x4e, 0x28, 0x00, 0x3c, 0x00, 0x81, 0xff, 0x4e,
+  0x78, 0x81, 0xff, 0x4e, 0x78, 0x81, 0xff, 0x4e, 0x78, 0x81, 0xff, 0x4e,
+  0x78, 0x00, 0x50, 0x00, 0x81, 0xff, 0x4e, 0x28, 0x81, 0xff, 0x4e, 0x28,
+  0x81, 0xff, 0x4e, 0x28, 0x81, 0xff, 0x4e, 0x28, 0x00, 0x78, 0x00, 0x7c,
+  0x08, 0x00, 0x50, 0x00, 0x81, 0xff, 0x4e, 0x28, 0x81, 0xff, 0x4e, 0x28,
+  0x81, 0xff, 0x4e, 0x28, 0x81, 0xff, 0x4e, 0x28, 0x00, 0x3c, 0x00, 0x81,
+  0xff, 0x4e, 0x78, 0x81, 0xff, 0x4e, 0x78, 0x81, 0xff, 0x4e, 0x78, 0x81,
+  0xff, 0x4e, 0x78, 0x00, 0x50, 0x00, 0x81, 0xff, 0x4e, 0x28, 0x81, 0xff,
+  0x4e, 0x28, 0x81, 0xff, 0x4e, 0x28, 0x81, 0xff, 0x4e, 0x28, 0x00, 0x90,
+  0x01, 0x7c, 0x08, 0x00, 0x00, 0x00,
+};
+
@@ -0,0 +1,10 @@
+/* generated by scripts/frames2anim.py -- do not edit */
+
+#ifndef __FRAMES_H__
+#define __FRAMES_H__
+
+#include <stdint.h>
+
+extern const uint8_t FRAMES_HEARTBEAT[126]; /* 8 frames */
+
+#endif /* end of include guard: __FRAMES_H__ */
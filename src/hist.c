@@ -0,0 +1,81 @@
+/** file:       hist.c
+  * created:    2026-10-17 16:20:08
+  */
+
+//___ I N C L U D E S ________________________________________________________
+#include <stddef.h>
+#include <string.h>
+#include "hist.h"
+#include "main.h"
+#include "aclock.h"
+
+//___ M A C R O S   ( P R I V A T E ) ________________________________________
+
+/* A set as logged, without the struct's tail padding */
+#define HIST_STATS_LOG_SIZE \
+  ( offsetof(hist_stats_t, hist) + sizeof(((hist_stats_t *) 0)->hist) )
+
+//___ T Y P E D E F S   ( P R I V A T E ) ____________________________________
+
+//___ P R O T O T Y P E S   ( P R I V A T E ) ________________________________
+
+//___ V A R I A B L E S ______________________________________________________
+
+//___ I N T E R R U P T S  ___________________________________________________
+
+//___ F U N C T I O N S   ( P R I V A T E ) __________________________________
+
+//___ F U N C T I O N S ______________________________________________________
+
+void hist_stats_init( hist_stats_t stats[], uint8_t count ) {
+  uint8_t i;
+
+  memset(stats, 0, count * sizeof(hist_stats_t));
+  for (i = 0; i < count; i++) {
+    stats[i].min = UINT32_MAX;
+  }
+}
+
+void hist_stats_add( hist_stats_t *stats, uint32_t value ) {
+  uint32_t v;
+  uint8_t bin = 0;
+
+  stats->count++;
+  stats->total += value;
+  if (value < stats->min) stats->min = value;
+  if (value > stats->max) stats->max = value;
+
+  /* no clz on the M0+ */
+  for (v = value >> 1; v && bin < HIST_BINS - 1; v >>= 1) {
+    bin++;
+  }
+  if (stats->hist[bin] < UINT16_MAX) stats->hist[bin]++;
+}
+
+uint32_t hist_stats_mean( const hist_stats_t *stats ) {
+  if (!stats->count) return 0;
+
+  return stats->total / stats->count;
+}
+
+void hist_stats_log( uint8_t code, const uint32_t counters[],
+    uint8_t counter_count, const hist_stats_t stats[], uint8_t count ) {
+  /* Only the last write is flushed as a flush writes the row for each
+   * byte */
+  uint8_t start_code[3] = { code, code, code };
+  int32_t timestamp = aclock_get_timestamp();
+  uint8_t i;
+
+  main_log_data(start_code, 3, false);
+  main_log_data((uint8_t *) &timestamp, 4, false);
+  main_log_data((uint8_t *) counters, counter_count * sizeof(uint32_t),
+      false);
+
+  for (i = 0; i < count; i++) {
+    main_log_data((uint8_t *) &stats[i], HIST_STATS_LOG_SIZE, false);
+  }
+
+  main_log_data(&count, 1, true);
+}
+
+// vim:shiftwidth=2
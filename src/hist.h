@@ -0,0 +1,66 @@
+/** file:       hist.h
+  * created:    2026-10-17 16:20:08
+  *
+  * run time stats shared by the profiler (prof.h) and wake tracer
+  * (trace.h).  Each set of stats keeps the min/mean/max of its runs and
+  * a log2 histogram, in whatever unit the caller times them.  Records
+  * of several sets are written to the nvm log by hist_stats_log() and
+  * decoded by scripts/stats_summary.py
+  */
+
+#ifndef __HIST_H__
+#define __HIST_H__
+
+//___ I N C L U D E S ________________________________________________________
+#include <stdint.h>
+#include <stdbool.h>
+
+//___ M A C R O S ____________________________________________________________
+
+/* Histogram bin n counts runs of 2^n to 2^(n+1) - 1 (the last also
+ * counts longer ones) */
+#define HIST_BINS               20
+
+//___ T Y P E D E F S ________________________________________________________
+typedef struct hist_stats_t {
+  uint64_t total;       // time of all runs
+  uint32_t count;       // # of runs
+  uint32_t min;
+  uint32_t max;
+  uint16_t hist[ HIST_BINS ];
+} hist_stats_t;
+
+//___ V A R I A B L E S ______________________________________________________
+
+//___ P R O T O T Y P E S ____________________________________________________
+
+void hist_stats_init( hist_stats_t stats[], uint8_t count );
+  /* @brief clear sets of stats
+   * @param stats, # of sets
+   * @retrn None
+   */
+
+void hist_stats_add( hist_stats_t *stats, uint32_t value );
+  /* @brief add a run to a set of stats
+   * @param stats, time the run took
+   * @retrn None
+   */
+
+uint32_t hist_stats_mean( const hist_stats_t *stats );
+  /* @brief get the mean time of the runs
+   * @param stats
+   * @retrn mean (0 if there are no runs)
+   */
+
+void hist_stats_log( uint8_t code, const uint32_t counters[],
+    uint8_t counter_count, const hist_stats_t stats[], uint8_t count );
+  /* @brief write a record of sets of stats to the nvm log: the start
+   *   code (x3), timestamp, counters, each set then the # of sets
+   * @param code telling the record type, the record's counters and
+   *   their #, sets of stats and their #
+   * @retrn None
+   */
+
+#endif /* end of include guard: __HIST_H__ */
+
+// vim:shiftwidth=2
@@ -6,6 +6,7 @@
 
 //___ I N C L U D E S ________________________________________________________
 #include "leds.h"
+#include "prof.h"
 #include <string.h>
 
 #define SEGMENTS_H
@@ -15,6 +16,59 @@
 #define SEGMENT_COUNT           12
 #define BANK_COUNT              5
 
+#ifndef LED_DMA_SCAN
+#define LED_DMA_SCAN false
+#endif
+/* Stream the multiplex scan to PORTA with the DMAC (one transfer per
+ * PWM_BASE_TIMER overflow) instead of running tc_pwm_isr per slot */
+
+#ifndef LED_BCM_BITS
+#define LED_BCM_BITS 6
+#endif
+
+#if (LED_BCM && LED_DMA_SCAN)
+#error "LED_BCM and LED_DMA_SCAN can not be combined"
+#endif
+
+#if (LED_DMA_SCAN)
+#ifndef DMAC
+#error "LED_DMA_SCAN requires a part with a DMAC (e.g. samd21)"
+#endif
+#if !defined(SEGMENTS_H) || defined(BANKS_H)
+#error "LED_DMA_SCAN assumes active high segments and active low banks"
+#endif
+#endif  /* LED_DMA_SCAN */
+
+/* # of bit-planes scanned per bank.  Plane i is on for a weight of
+ * 2^i (by repeating it 2^i slots, or by its period in BCM mode) */
+#if (LED_BCM)
+#define SCAN_PLANES         LED_BCM_BITS
+#else
+#define SCAN_PLANES         BRIGHT_LEVELS
+#endif
+
+/* # of scan slots in a full frame (each plane i repeats 2^i times) */
+#define SCAN_SLOT_COUNT     ( BANK_COUNT * ((1 << SCAN_PLANES) - 1) )
+
+/* An led's plane pattern is also the number of units (bank slots of
+ * the first plane) it is lit per frame, so summing the patterns gives
+ * the frame's charge.  A full brightness led is lit every plane */
+#define CHARGE_FULL_LED     ( (1 << SCAN_PLANES) - 1 )
+
+/* Limit of the frame charge in full brightness led equivalents.
+ * Committed frames over it are scaled down (0 = no limit) */
+#ifndef LED_CHARGE_LIMIT
+#define LED_CHARGE_LIMIT 0
+#endif
+#define CHARGE_LIMIT        ( LED_CHARGE_LIMIT * CHARGE_FULL_LED )
+
+/* DMA channels for the scan.  Both are triggered by the same overflow
+ * and the lower channel is served first, so segments are cleared and
+ * the new bank enabled before its segments are set */
+#define LED_DMA_CH_BANK     0   /* OUTCLR: all segments and next bank */
+#define LED_DMA_CH_FRAME    1   /* OUTSET: lit segments and other banks */
+#define LED_DMA_CH_COUNT    2
+
 /* values for configuring the fastest clock interval */
 #define VISION_PERSIST_MS   15      /* interval before noticeable blink */
 #define TC_FREQ_MHz         8       /* clock for the TC module */
@@ -23,6 +77,22 @@
 #define BANK_SELECT_TIMER   TC4
    /* counts from 0 to 4, does not trigger an interrupt */
 
+#if (LED_BCM)
+/* timer counts for the least significant plane.  A frame is
+ * BANK_COUNT * (2^LED_BCM_BITS - 1) of these */
+#define BCM_UNIT_COUNT      ( VISION_PERSIST_MS * TC_FREQ_MHz * 1000UL / \
+                              ( BANK_COUNT * ((1UL << LED_BCM_BITS) - 1) ) )
+
+#if (BCM_UNIT_COUNT < 150)
+#error "LED_BCM_BITS too large: shortest plane can not fit the isr"
+#endif
+/* Dark banks are merged into one period, which in the longest plane
+ * may be all of them, and must fit the 16-bit timer */
+#if (BANK_COUNT * (BCM_UNIT_COUNT << (LED_BCM_BITS - 1)) > 0x10000)
+#error "LED_BCM_BITS too small: longest plane overflows the timer"
+#endif
+#endif  /* LED_BCM */
+
 //#define PWM_SELECT_TIMER    AVR32_TC.bank[1]
   /* counts from 0 to MAX_BRIGHT_VAL, triggers the tc_bank_isr interrupt */
 
@@ -37,18 +107,11 @@
 #define CONF_EVENT_BRIGHT_INC_GEN_ID       EVSYS_ID_GEN_TC4_MCX_4
 #define CONF_EVENT_BRIGHT_INC_USER_ID            EVSYS_ID_USER_TC5_EVU
 
-/* return the bank/segment ID for the given led index */
-#define LED_SEGMENT(led_index)      ( led_index / BANK_COUNT )
+#define LED_COUNT           ( BANK_COUNT * SEGMENT_COUNT )
 
-/* LED Bank numbering is 0,1,2,3,4,0,4,3,2,1,0,....
- * therefore calculating the bank # for a given LED # is
- * tricky.  If the led's segment is odd, then the bank
- * is simply the led # modulo 5.  Otherwise, it is
- * either 0 (if its one of the 'hour' tick leds) or 5 minus
- * the led # modulo 5
- */
-#define LED_BANK(i)                 \
-  ( LED_SEGMENT(i) % 2 ? (i % 5 ? (5-(i % 5)) : 0 ) : i % 5 )
+/* return the bank/segment ID for the given led index */
+#define LED_SEGMENT(led_index)      ( LED_ADDRS[ led_index ].segment )
+#define LED_BANK(led_index)         ( LED_ADDRS[ led_index ].bank )
 
 
 #define BANK_GPIO( bank_number ) LED_BANK_GPIO_PINS[bank_number]
@@ -140,13 +203,62 @@
 
 
 //___ T Y P E D E F S   ( P R I V A T E ) ____________________________________
+/* Where an led is in the multiplex */
+typedef struct led_addr_t {
+  uint8_t bank;
+  uint8_t segment;
+  uint32_t mask;        // segment pin mask in PORTA
+} led_addr_t;
+
+/* Segment masks of every bank for each scan plane */
+typedef uint32_t led_masks_t[ BANK_COUNT ][ SCAN_PLANES ];
 
 //___ P R O T O T Y P E S   ( P R I V A T E ) ________________________________
+static void led_masks_set ( uint8_t led, uint8_t fine );
+  /* @brief write an led's (capped) intensity to the back masks
+   * @param led num (0-59)
+   * @param fine intensity (0-LED_FINE_MAX)
+   * @retrn None
+   */
+
+static void pending_masks_limit ( void );
+  /* @brief write the back buffer to the pending masks with every led
+   *   scaled down to fit the charge limit
+   * @param None
+   * @retrn None
+   */
+
+#if !(LED_DMA_SCAN)
 static void tc_pwm_isr ( struct tc_module *const tc_instance);
   /* @brief initialize led module
    * @param None
    * @retrn None
    */
+#else
+static void configure_dma ( void );
+  /* @brief configure the dma channels streaming the scan frame
+   * @param None
+   * @retrn None
+   */
+
+static void dma_channel_reset ( uint8_t ch );
+  /* @brief reset a scan dma channel to the start of its descriptor
+   * @param dma channel
+   * @retrn None
+   */
+
+static void dma_scan_enable ( bool enable );
+  /* @brief start (from the first slot) or stop the dma scan
+   * @param enable - true to start
+   * @retrn None
+   */
+
+static void scan_frame_build ( uint32_t *frame );
+  /* @brief write all scan frame slots from the front masks
+   * @param frame buffer to write
+   * @retrn None
+   */
+#endif  /* LED_DMA_SCAN */
 
 static void configure_tc ( void );
   /* @brief configure the timer / counter
@@ -154,6 +266,32 @@ static void configure_tc ( void );
    * @retrn None
    */
 
+static void scan_start ( void );
+  /* @brief start the scan from the beginning of a frame
+   * @param None
+   * @retrn None
+   */
+
+static void scan_stop ( void );
+  /* @brief stop the scan and turn off all banks/segments
+   * @param None
+   * @retrn None
+   */
+
+static void bank_lit_update ( uint8_t bank );
+  /* @brief update the lit summary of a back buffer bank after
+   *   its masks changed
+   * @param bank that changed
+   * @retrn None
+   */
+
+static inline void frame_swap ( void );
+  /* @brief show the committed frame if there is one.  Only called
+   *   at a frame boundary or with the scan stopped
+   * @param None
+   * @retrn None
+   */
+
 
 //___ V A R I A B L E S ______________________________________________________
 const uint8_t LED_BANK_GPIO_PINS[BANK_COUNT] = {
@@ -179,20 +317,194 @@ const uint8_t LED_SEGMENT_GPIO_PINS[SEGMENT_COUNT] = {
   PIN_PA19
 };
 
+/* LED Bank numbering is 0,1,2,3,4,0,4,3,2,1,0,....
+ * If the led's segment is even, then the bank is simply the led #
+ * modulo 5.  Otherwise, it is either 0 (if its one of the 'hour'
+ * tick leds) or 5 minus the led # modulo 5.  This is tabled since
+ * the M0+ has no divider */
+static const led_addr_t LED_ADDRS[ LED_COUNT ] = {
+  { 0,  0, 1UL << PIN_PA16 },
+  { 1,  0, 1UL << PIN_PA16 },
+  { 2,  0, 1UL << PIN_PA16 },
+  { 3,  0, 1UL << PIN_PA16 },
+  { 4,  0, 1UL << PIN_PA16 },
+  { 0,  1, 1UL << PIN_PA15 },
+  { 4,  1, 1UL << PIN_PA15 },
+  { 3,  1, 1UL << PIN_PA15 },
+  { 2,  1, 1UL << PIN_PA15 },
+  { 1,  1, 1UL << PIN_PA15 },
+  { 0,  2, 1UL << PIN_PA14 },
+  { 1,  2, 1UL << PIN_PA14 },
+  { 2,  2, 1UL << PIN_PA14 },
+  { 3,  2, 1UL << PIN_PA14 },
+  { 4,  2, 1UL << PIN_PA14 },
+  { 0,  3, 1UL << PIN_PA11 },
+  { 4,  3, 1UL << PIN_PA11 },
+  { 3,  3, 1UL << PIN_PA11 },
+  { 2,  3, 1UL << PIN_PA11 },
+  { 1,  3, 1UL << PIN_PA11 },
+  { 0,  4, 1UL << PIN_PA07 },
+  { 1,  4, 1UL << PIN_PA07 },
+  { 2,  4, 1UL << PIN_PA07 },
+  { 3,  4, 1UL << PIN_PA07 },
+  { 4,  4, 1UL << PIN_PA07 },
+  { 0,  5, 1UL << PIN_PA06 },
+  { 4,  5, 1UL << PIN_PA06 },
+  { 3,  5, 1UL << PIN_PA06 },
+  { 2,  5, 1UL << PIN_PA06 },
+  { 1,  5, 1UL << PIN_PA06 },
+  { 0,  6, 1UL << PIN_PA05 },
+  { 1,  6, 1UL << PIN_PA05 },
+  { 2,  6, 1UL << PIN_PA05 },
+  { 3,  6, 1UL << PIN_PA05 },
+  { 4,  6, 1UL << PIN_PA05 },
+  { 0,  7, 1UL << PIN_PA04 },
+  { 4,  7, 1UL << PIN_PA04 },
+  { 3,  7, 1UL << PIN_PA04 },
+  { 2,  7, 1UL << PIN_PA04 },
+  { 1,  7, 1UL << PIN_PA04 },
+  { 0,  8, 1UL << PIN_PA28 },
+  { 1,  8, 1UL << PIN_PA28 },
+  { 2,  8, 1UL << PIN_PA28 },
+  { 3,  8, 1UL << PIN_PA28 },
+  { 4,  8, 1UL << PIN_PA28 },
+  { 0,  9, 1UL << PIN_PA27 },
+  { 4,  9, 1UL << PIN_PA27 },
+  { 3,  9, 1UL << PIN_PA27 },
+  { 2,  9, 1UL << PIN_PA27 },
+  { 1,  9, 1UL << PIN_PA27 },
+  { 0, 10, 1UL << PIN_PA22 },
+  { 1, 10, 1UL << PIN_PA22 },
+  { 2, 10, 1UL << PIN_PA22 },
+  { 3, 10, 1UL << PIN_PA22 },
+  { 4, 10, 1UL << PIN_PA22 },
+  { 0, 11, 1UL << PIN_PA19 },
+  { 4, 11, 1UL << PIN_PA19 },
+  { 3, 11, 1UL << PIN_PA19 },
+  { 2, 11, 1UL << PIN_PA19 },
+  { 1, 11, 1UL << PIN_PA19 }
+};
+
 static struct tc_module pwm_tc_instance;
 static struct tc_module bank_tc_instance;
 
 static struct events_resource bank_inc_event;
 
-#define BRIGHT_INDEX_MAX    BRIGHT_LEVELS - 1
+/* Fine (8-bit) intensity of each brightness level.  Chosen so that
+ * a gamma of 2.2 they match the 1/31, 3/31, ... 31/31 duty of
+ * the (non-BCM) brightness levels */
+#define LEVEL_FINE_1        53
+#define LEVEL_FINE_2        88
+#define LEVEL_FINE_3        130
+#define LEVEL_FINE_4        183
+
+const uint8_t LED_LEVEL_FINE[ BRIGHT_LEVELS + 1 ] = {
+  0, LEVEL_FINE_1, LEVEL_FINE_2, LEVEL_FINE_3, LEVEL_FINE_4, LED_FINE_MAX
+};
+
+#if (LED_BCM)
+/* Bit-planes (bit i set = plane i lit) of each fine intensity: its linear duty (gamma 2.2) in
+ * LED_BCM_BITS bits, keeping the dimmest non-zero intensities visible */
+#define BCM_PLANES( duty ) \
+  ( ((duty) >> (8 - LED_BCM_BITS)) ? ((duty) >> (8 - LED_BCM_BITS)) : 1 )
+#define BCM_ROW( a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p ) \
+  BCM_PLANES(a), BCM_PLANES(b), BCM_PLANES(c), BCM_PLANES(d), \
+  BCM_PLANES(e), BCM_PLANES(f), BCM_PLANES(g), BCM_PLANES(h), \
+  BCM_PLANES(i), BCM_PLANES(j), BCM_PLANES(k), BCM_PLANES(l), \
+  BCM_PLANES(m), BCM_PLANES(n), BCM_PLANES(o), BCM_PLANES(p)
+
+static const uint8_t plane_patterns[ LED_FINE_MAX + 1 ] = {
+  0, /* off */
+  BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(0),
+  BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(0),
+  BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(0), BCM_PLANES(1),
+  BCM_ROW(  1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2),
+  BCM_ROW(  3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6),
+  BCM_ROW(  6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12),
+  BCM_ROW( 12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19),
+  BCM_ROW( 20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29),
+  BCM_ROW( 30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41),
+  BCM_ROW( 42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55),
+  BCM_ROW( 56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71),
+  BCM_ROW( 73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90),
+  BCM_ROW( 91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111),
+  BCM_ROW(113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135),
+  BCM_ROW(137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161),
+  BCM_ROW(163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190),
+  BCM_ROW(192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221),
+  BCM_ROW(223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255)
+};
+#else
+/* Bit-planes of each fine intensity.  Brightness levels are shown with
+ * thermometer code, i.e. the planes of every level up to its own */
+#if (BRIGHT_LEVELS != 5)
+#error "plane_patterns assumes 5 brightness levels"
+#endif
+#define THERMO_PLANES( fine ) \
+  ( (fine) >= LED_FINE_MAX ? 0x1f : (fine) >= LEVEL_FINE_4 ? 0x0f : \
+    (fine) >= LEVEL_FINE_3 ? 0x07 : (fine) >= LEVEL_FINE_2 ? 0x03 : \
+    (fine) >= LEVEL_FINE_1 ? 0x01 : 0 )
+#define THERMO_4( f )   THERMO_PLANES(f), THERMO_PLANES(f + 1), \
+                        THERMO_PLANES(f + 2), THERMO_PLANES(f + 3)
+#define THERMO_16( f )  THERMO_4(f), THERMO_4(f + 4), THERMO_4(f + 8), \
+                        THERMO_4(f + 12)
+#define THERMO_64( f )  THERMO_16(f), THERMO_16(f + 16), THERMO_16(f + 32), \
+                        THERMO_16(f + 48)
+
+static const uint8_t plane_patterns[ LED_FINE_MAX + 1 ] = {
+  THERMO_64(0), THERMO_64(64), THERMO_64(128), THERMO_64(192)
+};
+#endif  /* LED_BCM */
+
+#define BRIGHT_INDEX_MAX    SCAN_PLANES - 1
 static uint8_t bright_index;      // current brightness level
 static uint16_t brightness_ctr = 1;      // counter for incrementing bright index
 static uint8_t bank_ctr = BANK_COUNT;
 static uint8_t max_brightness = MAX_BRIGHT_VAL;
-static uint8_t led_intensities[ BANK_COUNT ][ SEGMENT_COUNT ];
-static uint32_t led_segment_masks[ BANK_COUNT ][ BRIGHT_LEVELS ];
+static uint8_t led_intensities[ LED_COUNT ];
+static uint8_t led_patterns[ LED_COUNT ];       // back buffer patterns
+static uint16_t back_charge = 0;                // sum of led_patterns
+static led_charge_stats_t charge_stats = {
+  .full_led = CHARGE_FULL_LED,
+  .limit = CHARGE_LIMIT
+};
+
+/* Masks are written to the back buffer and copied to the pending
+ * buffer by led_commit.  The scan swaps the pending and front buffers
+ * at a frame boundary so it never shows a partially updated frame */
+static led_masks_t mask_buffers[ 3 ];
+static led_masks_t * volatile scan_masks = &mask_buffers[ 0 ];
+static led_masks_t * volatile pending_masks = &mask_buffers[ 1 ];
+static led_masks_t * const back_masks = &mask_buffers[ 2 ];
+static volatile bool commit_pending = false;
+static bool back_dirty = false;             // back changed since commit
+
+/* Bank has any led lit (bit per bank).  Dark banks are skipped and the
+ * scan is stopped at the end of a frame when nothing is lit */
+static volatile uint8_t lit_banks = 0;      // front buffer
+static volatile uint8_t pending_lit_banks = 0;
+static uint8_t back_lit_banks = 0;
+static bool scan_enabled = false;           // led controller is enabled
+static volatile bool scan_running = false;
+static uint16_t scan_unit_count;            // timer counts of a 1 bank slot
+static uint16_t scan_top;                   // current timer top
+
+#if (LED_DMA_SCAN)
+/* PORTA words streamed by the DMAC.  Slot k of the frame belongs to
+ * bank k % BANK_COUNT; planes follow each other in order, each
+ * repeated 2^plane times (the same sequence tc_pwm_isr produces) */
+static uint32_t scan_bank_words[ BANK_COUNT ];
+static uint32_t scan_frame[ 2 ][ SCAN_SLOT_COUNT ];
+static uint8_t scan_frame_next = 0;         // frame the descriptor loads
+
+static DmacDescriptor dma_descriptors[ LED_DMA_CH_COUNT ]
+  __attribute__ ((aligned (16)));
+static DmacDescriptor dma_writeback[ LED_DMA_CH_COUNT ]
+  __attribute__ ((aligned (16)));
+#endif  /* LED_DMA_SCAN */
 
 //___ I N T E R R U P T S  ___________________________________________________
+#if !(LED_DMA_SCAN)
 static void tc_pwm_isr ( struct tc_module *const tc_inst) {
 
   /* Getting the current bank index from the timer counter
@@ -200,20 +512,58 @@ static void tc_pwm_isr ( struct tc_module *const tc_inst) {
    * variable.  This is probably related to synchronization
    * issues that should be investigated */
   //bank = tc_get_count_value(&bank_tc_instance);
+  uint32_t stamp = prof_stamp();
+  uint8_t span = 1;
+  uint16_t top;
+
   bank_ctr--;
 
   /* switch to next bank */
   BANKS_SEGMENTS_CLEAR();
 
-  /* Enable (toggle low) the specific led segments applying mask to "clear" register */
+  if (lit_banks & (1 << bank_ctr)) {
+    /* Enable (toggle low) the specific led segments applying mask to "clear" register */
 #ifdef SEGMENTS_H
-  PORTA.OUTSET.reg  = led_segment_masks[bank_ctr][bright_index];
+    PORTA.OUTSET.reg  = (*scan_masks)[bank_ctr][bright_index];
+#else
+    PORTA.OUTCLR.reg  = (*scan_masks)[bank_ctr][bright_index];
+#endif
+
+    BANK_ENABLE( bank_ctr );
+  } else {
+    /* Merge a run of dark banks into one blank period of the same
+     * total length, so lit banks keep their duty (and brightness) */
+    while (bank_ctr && !(lit_banks & (1 << (bank_ctr - 1)))) {
+      bank_ctr--;
+      span++;
+    }
+  }
+
+  /* This period was just started so set its length (the count
+   * is still well below any top) */
+#if (LED_BCM)
+  top = span * (scan_unit_count << bright_index) - 1;
 #else
-  PORTA.OUTCLR.reg  = led_segment_masks[bank_ctr][bright_index];
+  top = span * scan_unit_count - 1;
 #endif
+  if (top != scan_top) {
+    scan_top = top;
+    PWM_BASE_TIMER->COUNT16.CC[0].reg = top;
+  }
 
-  BANK_ENABLE( bank_ctr );
+#if (LED_BCM)
+  /* Switch to the next plane after each full bank cycle */
+  if (bank_ctr == 0) {
+    bank_ctr = BANK_COUNT;
+    bright_index = bright_index < BRIGHT_INDEX_MAX ? bright_index + 1 : 0;
 
+    if (!bright_index) {
+      /* end of a frame */
+      frame_swap();
+      if (!lit_banks) scan_stop();
+    }
+  }
+#else
 
   /* Switch to next brightness level after each full bank cycle */
   if (bank_ctr == 0) {
@@ -230,11 +580,37 @@ static void tc_pwm_isr ( struct tc_module *const tc_inst) {
         if (bright_index > BRIGHT_INDEX_MAX) {
             bright_index = 0;
             brightness_ctr = 1;
+
+            /* end of a frame */
+            frame_swap();
+            if (!lit_banks) scan_stop();
         }
     }
   }
+#endif  /* LED_BCM */
 
+  prof_record(PROF_LED_ISR, stamp);
 }
+#else
+void DMAC_Handler( void ) {
+  DmacDescriptor *desc = &dma_descriptors[LED_DMA_CH_FRAME];
+
+  /* frame channel completed a frame and has already reloaded its
+   * descriptor, so the other frame buffer is free until the next one */
+  DMAC->INTPEND.reg = DMAC_INTPEND_ID(LED_DMA_CH_FRAME) | DMAC_INTPEND_TCMPL;
+
+  if (commit_pending) {
+    frame_swap();
+    scan_frame_next ^= 1;
+    scan_frame_build(scan_frame[scan_frame_next]);
+    desc->SRCADDR.reg = (uint32_t) &scan_frame[scan_frame_next][SCAN_SLOT_COUNT];
+  }
+
+  if (!lit_banks) {
+    scan_stop();
+  }
+}
+#endif  /* !LED_DMA_SCAN */
 
 //___ F U N C T I O N S   ( P R I V A T E ) __________________________________
 static void configure_tc ( void ) {
@@ -255,14 +631,22 @@ static void configure_tc ( void ) {
     *
     * count_top = 10 * 1600 >> 4 = 10 * 100 = 1000
     */
+#if (LED_BCM)
+  /* BCM starts with the least significant plane, the isr sets the
+   * top for each plane after that */
+  const uint16_t pwm_base_count_top = BCM_UNIT_COUNT - 1;
+#else
   const uint32_t count_period_ns = 1e6 * VISION_PERSIST_MS / \
                                    ( BANK_COUNT * (1<<BRIGHT_LEVELS) );
   const uint32_t TC_period_ns = 1e3 / TC_FREQ_MHz;
   const uint16_t pwm_base_count_top = (uint16_t) (count_period_ns / TC_period_ns);
+#endif  /* LED_BCM */
 
   struct tc_config config_tc;
+#if !(LED_DMA_SCAN)
   struct tc_events events_tc;
   struct events_config config_ev;
+#endif
 
   /* Configure highest frequency counter for led PWM */
   tc_get_config_defaults( &config_tc );
@@ -274,6 +658,13 @@ static void configure_tc ( void ) {
 
   tc_init(&pwm_tc_instance, PWM_BASE_TIMER, &config_tc);
 
+  scan_unit_count = pwm_base_count_top + 1;
+  scan_top = pwm_base_count_top;
+
+#if (LED_DMA_SCAN)
+  /* The overflow triggers the dma directly, no bank counter needed */
+  configure_dma();
+#else
   tc_register_callback( &pwm_tc_instance,
       tc_pwm_isr, TC_CALLBACK_CC_CHANNEL0);
 
@@ -307,13 +698,233 @@ static void configure_tc ( void ) {
 
   events_allocate(&bank_inc_event, &config_ev);
   events_attach_user(&bank_inc_event, CONF_EVENT_BANK_INC_USER_ID);
+#endif  /* LED_DMA_SCAN */
 }
 
+#if (LED_DMA_SCAN)
+static void configure_dma ( void ) {
+  DmacDescriptor *desc;
+  uint8_t ch;
+  uint8_t bank;
+
+  system_ahb_clock_set_mask(PM_AHBMASK_DMAC);
+  system_apb_clock_set_mask(SYSTEM_CLOCK_APB_APBB, PM_APBBMASK_DMAC);
+
+  DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+  DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+  while (DMAC->CTRL.reg & DMAC_CTRL_SWRST);
+
+  DMAC->BASEADDR.reg = (uint32_t) dma_descriptors;
+  DMAC->WRBADDR.reg = (uint32_t) dma_writeback;
+
+  /* Constant per-bank clear words.  Clearing a bank's (active low)
+   * pin enables it */
+  for (bank = 0; bank < BANK_COUNT; bank++) {
+    scan_bank_words[bank] = SEGMENT_PIN_PORT_MASK | 1UL << BANK_GPIO(bank);
+  }
+  scan_frame_build(scan_frame[scan_frame_next]);
+
+  /* Both descriptors link to themselves so the scan repeats forever
+   * without cpu intervention.  Note the dma source address is the
+   * end of the block when incrementing */
+  desc = &dma_descriptors[LED_DMA_CH_BANK];
+  desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_WORD |
+    DMAC_BTCTRL_SRCINC;
+  desc->BTCNT.reg = BANK_COUNT;
+  desc->SRCADDR.reg = (uint32_t) &scan_bank_words[BANK_COUNT];
+  desc->DSTADDR.reg = (uint32_t) &PORTA.OUTCLR.reg;
+  desc->DESCADDR.reg = (uint32_t) desc;
+
+  /* The frame channel interrupts once per frame so a blank scan
+   * can be stopped */
+  desc = &dma_descriptors[LED_DMA_CH_FRAME];
+  desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_WORD |
+    DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_INT;
+  desc->BTCNT.reg = SCAN_SLOT_COUNT;
+  desc->SRCADDR.reg = (uint32_t) &scan_frame[scan_frame_next][SCAN_SLOT_COUNT];
+  desc->DSTADDR.reg = (uint32_t) &PORTA.OUTSET.reg;
+  desc->DESCADDR.reg = (uint32_t) desc;
+
+  for (ch = 0; ch < LED_DMA_CH_COUNT; ch++) {
+    dma_channel_reset(ch);
+  }
+
+  DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN0;
+
+  NVIC_EnableIRQ(DMAC_IRQn);
+}
+
+static void dma_channel_reset ( uint8_t ch ) {
+  DMAC->CHID.reg = DMAC_CHID_ID(ch);
+  DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+  while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE);
+
+  DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+  while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST);
+
+  /* one word per overflow */
+  DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) |
+    DMAC_CHCTRLB_TRIGSRC(TC3_DMAC_ID_OVF) | DMAC_CHCTRLB_TRIGACT_BEAT;
+
+  if (ch == LED_DMA_CH_FRAME) {
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+  }
+}
+
+static void dma_scan_enable ( bool enable ) {
+  uint8_t ch;
+
+  for (ch = 0; ch < LED_DMA_CH_COUNT; ch++) {
+    if (enable) {
+      DMAC->CHID.reg = DMAC_CHID_ID(ch);
+      DMAC->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+    } else {
+      /* Reset so both channels restart from the first slot, keeping
+       * the bank and frame channels in step */
+      dma_channel_reset(ch);
+    }
+  }
+}
+
+static void scan_frame_build ( uint32_t *frame ) {
+  uint32_t other_banks;
+  uint32_t *slot_ptr;
+  uint16_t repeat;
+  uint8_t bank, i;
+
+  for (bank = 0; bank < BANK_COUNT; bank++) {
+    other_banks = BANK_PIN_PORT_MASK & ~(1UL << BANK_GPIO( bank ));
+    slot_ptr = &frame[bank];
+
+    for (i = 0; i < SCAN_PLANES; i++) {
+      for (repeat = 1 << i; repeat; repeat--) {
+        *slot_ptr = (*scan_masks)[ bank ][ i ] | other_banks;
+        slot_ptr += BANK_COUNT;
+      }
+    }
+  }
+}
+#endif  /* LED_DMA_SCAN */
+
+static void scan_start ( void ) {
+  scan_running = true;
+
+#if (LED_DMA_SCAN)
+  dma_scan_enable(true);
+#else
+  bank_ctr = BANK_COUNT;
+  bright_index = 0;
+  brightness_ctr = 1;
+
+  tc_set_count_value(&pwm_tc_instance, 0);
+  tc_enable_callback(&pwm_tc_instance, TC_CALLBACK_CC_CHANNEL0);
+#endif  /* LED_DMA_SCAN */
+
+  tc_enable(&pwm_tc_instance);
+}
+
+static void scan_stop ( void ) {
+  tc_disable(&pwm_tc_instance);
+
+#if (LED_DMA_SCAN)
+  dma_scan_enable(false);
+#else
+  tc_disable_callback(&pwm_tc_instance, TC_CALLBACK_CC_CHANNEL0);
+#endif  /* LED_DMA_SCAN */
+
+  BANKS_SEGMENTS_CLEAR();
+  scan_running = false;
+}
+
+static void bank_lit_update ( uint8_t bank ) {
+  uint32_t lit = 0;
+  uint8_t i;
+
+  for (i = 0; i < SCAN_PLANES; i++) {
+    lit |= (*back_masks)[ bank ][ i ];
+  }
+
+  if (lit) {
+    back_lit_banks |= 1 << bank;
+  } else {
+    back_lit_banks &= ~(1 << bank);
+  }
+}
+
+static inline void frame_swap ( void ) {
+  led_masks_t *front;
+
+  if (!commit_pending) return;
+
+  front = scan_masks;
+  scan_masks = pending_masks;
+  pending_masks = front;
+  lit_banks = pending_lit_banks;
+  commit_pending = false;
+}
+
+static void led_masks_set ( uint8_t led, uint8_t fine ) {
+  const led_addr_t *addr = &LED_ADDRS[ led ];
+  uint32_t *masks = (*back_masks)[ addr->bank ];
+  uint8_t pattern;
+  uint8_t i;
+
+  if (fine > LED_LEVEL_FINE[ max_brightness ]) {
+    fine = LED_LEVEL_FINE[ max_brightness ];
+  }
+
+  pattern = plane_patterns[ fine ];
+
+  back_charge += pattern - led_patterns[ led ];
+  led_patterns[ led ] = pattern;
+
+  for (i = 0; i < SCAN_PLANES; i++) {
+      if (pattern & (1 << i))
+        masks[ i ] |= addr->mask;
+      else
+        masks[ i ] &= ~addr->mask;
+  }
+}
+
+static void pending_masks_limit ( void ) {
+  led_masks_t *masks = pending_masks;
+  /* 8.8 fixed point scale, the only divide of a commit */
+  uint16_t scale = ((uint32_t) CHARGE_LIMIT << 8) / back_charge;
+  uint16_t charge = 0;
+  uint8_t led, pattern, scaled;
+  uint8_t i;
+
+  memset(*masks, 0, sizeof(led_masks_t));
+
+  for (led = 0; led < LED_COUNT; led++) {
+    pattern = led_patterns[ led ];
+    if (!pattern) continue;
+
+    scaled = (pattern * scale) >> 8;
+#if !(LED_BCM)
+    /* Round down to a thermometer code */
+    pattern = 1;
+    while (((pattern << 1) | 1) <= scaled) pattern = (pattern << 1) | 1;
+#else
+    /* keep every lit led visible */
+    pattern = scaled ? scaled : 1;
+#endif
+
+    charge += pattern;
+    for (i = 0; i < SCAN_PLANES; i++) {
+      if (pattern & (1 << i)) {
+        (*masks)[ LED_BANK( led ) ][ i ] |= LED_ADDRS[ led ].mask;
+      }
+    }
+  }
+
+  charge_stats.frame = charge;
+  charge_stats.limited_count++;
+}
 
 //___ F U N C T I O N S ______________________________________________________
 
 void led_controller_init ( void ) {
-
   configure_tc();
 }
 
@@ -333,6 +944,7 @@ void led_controller_enable ( void ) {
   led_controller_conf_output();
 
   led_clear_all();
+  led_commit();
 
   /* Errata 12227: perform a software reset of tc after waking up */
   //tc_reset(&pwm_tc_instance);
@@ -340,25 +952,37 @@ void led_controller_enable ( void ) {
   
   //configure_tc();
     
-  tc_enable(&pwm_tc_instance);
-
+#if !(LED_DMA_SCAN)
   tc_enable(&bank_tc_instance);
   
-  tc_enable_callback(&pwm_tc_instance, TC_CALLBACK_CC_CHANNEL0);
   /* The bank tc shouldnt run -- it should only increment on pwm events
    * therefore, stop and reset its value immediately
    */
   tc_stop_counter(&bank_tc_instance);
   tc_set_count_value(&bank_tc_instance, 0);
+#endif  /* LED_DMA_SCAN */
+
+  /* The scan only runs while something is lit */
+  scan_enabled = true;
+  if (lit_banks) {
+    system_interrupt_disable_global();
+    scan_start();
+    system_interrupt_enable_global();
+  }
 
 }
 
 void led_controller_disable ( void ) {
   struct port_config pin_conf;
 
-  tc_disable_callback(&pwm_tc_instance, TC_CALLBACK_CC_CHANNEL0);
-  tc_disable(&pwm_tc_instance);
+  system_interrupt_disable_global();
+  scan_enabled = false;
+  scan_stop();
+  system_interrupt_enable_global();
+
+#if !(LED_DMA_SCAN)
   tc_disable(&bank_tc_instance);
+#endif
 
   SEGMENTS_CLEAR();
   BANKS_CLEAR();
@@ -373,36 +997,108 @@ void led_controller_disable ( void ) {
 
 
 void led_set_intensity ( uint8_t led, uint8_t intensity ) {
-  uint8_t bank = LED_BANK( led );
-  uint8_t segment = LED_SEGMENT( led );
-  uint8_t segment_gpio = SEGMENT_GPIO(segment);
-  uint8_t i;
+  led_set_intensity_fine( led, led_level_to_fine( intensity ) );
+}
 
+void led_set_intensity_fine ( uint8_t led, uint8_t fine ) {
 
+  /* the back buffer already holds this led's masks */
+  if (led_intensities[ led ] == fine) return;
 
-  led_intensities[bank][segment] = intensity;
+  led_intensities[ led ] = fine;
+  back_dirty = true;
 
-  for (i = 0; i < BRIGHT_LEVELS; i++) {
-      if (intensity > i && i < max_brightness)
-        led_segment_masks[ bank ][ i ] |= 1UL << segment_gpio;
-      else
-        led_segment_masks[ bank ][ i ] &= ~(1UL << segment_gpio);
+  led_masks_set( led, fine );
+  bank_lit_update( LED_BANK( led ) );
+}
+
+void led_set_frame ( const uint8_t levels[] ) {
+  uint8_t led, bank;
+
+  memset(*back_masks, 0, sizeof(led_masks_t));
+  memset(led_patterns, 0, sizeof(led_patterns));
+  back_charge = 0;
 
+  for (led = 0; led < LED_COUNT; led++) {
+    led_intensities[ led ] = levels[ led ];
+    if (levels[ led ]) led_masks_set( led, levels[ led ] );
   }
 
+  for (bank = 0; bank < BANK_COUNT; bank++) {
+    bank_lit_update( bank );
+  }
+
+  back_dirty = true;
+}
+
+void led_commit ( void ) {
+  if (!back_dirty) return;
+  back_dirty = false;
+
+  /* Withdraw any commit not shown yet (the scan can not swap in the
+   * pending buffer while we copy to it) */
+  commit_pending = false;
+  /* keep the copy's stores after the withdraw and before the commit */
+  __DMB();
+
+  if (back_charge > charge_stats.requested_max) {
+    charge_stats.requested_max = back_charge;
+  }
+
+  if (CHARGE_LIMIT && back_charge > CHARGE_LIMIT) {
+    pending_masks_limit();
+  } else {
+    memcpy(*pending_masks, *back_masks, sizeof(led_masks_t));
+    charge_stats.frame = back_charge;
+  }
+  pending_lit_banks = back_lit_banks;
+  __DMB();
+  commit_pending = true;
+
+  /* If the scan is stopped show it now, starting the scan if lit */
+  system_interrupt_disable_global();
+  if (!scan_running) {
+    frame_swap();
+#if (LED_DMA_SCAN)
+    scan_frame_build(scan_frame[scan_frame_next]);
+#endif
+    if (scan_enabled && lit_banks) scan_start();
+  }
+  system_interrupt_enable_global();
 }
 
 
 void led_clear_all( void ) {
-  /* clear (disable) all active leds */
-  BANKS_SEGMENTS_CLEAR();
-  memset(led_segment_masks, 0, BANK_COUNT*BRIGHT_LEVELS*sizeof(uint32_t));
+  /* clear (disable) all leds of the back buffer */
+  memset(*back_masks, 0, sizeof(led_masks_t));
+  memset(led_intensities, 0, sizeof(led_intensities));
+  memset(led_patterns, 0, sizeof(led_patterns));
+  back_charge = 0;
+  back_lit_banks = 0;
+  back_dirty = true;
 }
 
 void led_set_max_brightness( uint8_t brightness ) {
-    max_brightness = brightness;
+  uint8_t levels[ LED_COUNT ];
+
+  brightness = brightness > MAX_BRIGHT_VAL ? MAX_BRIGHT_VAL : brightness;
+  if (brightness == max_brightness) return;
+  max_brightness = brightness;
+
+  /* Reapply the new cap to every lit led */
+  memcpy(levels, led_intensities, sizeof(levels));
+  led_set_frame( levels );
+}
+
+
+const led_charge_stats_t * led_get_charge_stats( void ) {
+  return &charge_stats;
 }
 
+void led_reset_charge_stats( void ) {
+  charge_stats.requested_max = 0;
+  charge_stats.limited_count = 0;
+}
 
 void _led_on_full( uint8_t led ) {
   SEGMENT_ENABLE(LED_SEGMENT(led));
@@ -19,6 +19,13 @@
 #include <asf.h>
 
 //___ M A C R O S ____________________________________________________________
+#ifndef LED_BCM
+#define LED_BCM false
+#endif
+/* Binary code modulation: each bank shows one bit-plane of the led
+ * intensities per PWM_BASE_TIMER period and the period is scaled by
+ * the plane's weight, so a frame needs LED_BCM_BITS slots per bank */
+
 #define BRIGHT_LEVELS       5
 
 #define BRIGHT_DEFAULT      4
@@ -32,6 +39,9 @@
 #define BRIGHT_HIGH         5
 #define BRIGHT_MAX          MAX_BRIGHT_VAL
 
+/* Fine (8-bit) intensities, perceptually spaced */
+#define LED_FINE_MAX        255
+
 /* Non-pwm blink of LEDs -- bypassing the LED TC controller */
 #define _BLINK( i )  do { \
       _led_on_full( i ); \
@@ -44,8 +54,18 @@
       delay_ms(50); \
     } while(0);
 //___ T Y P E D E F S ________________________________________________________
+/* Estimated led charge per frame, in units of one led lit for one bank
+ * slot of the first (shortest) plane */
+typedef struct led_charge_stats_t {
+  uint16_t full_led;        // charge of one full brightness led
+  uint16_t limit;           // frame charge limit (0 = none)
+  uint16_t frame;           // last committed frame, after limiting
+  uint16_t requested_max;   // largest frame committed before limiting
+  uint16_t limited_count;   // # of commits scaled down to the limit
+} led_charge_stats_t;
 
 //___ V A R I A B L E S ______________________________________________________
+extern const uint8_t LED_LEVEL_FINE[ BRIGHT_LEVELS + 1 ];
 
 //___ P R O T O T Y P E S ____________________________________________________
 void led_controller_init( void );
@@ -75,12 +95,35 @@ void led_controller_enable( void );
    */
 
 void led_set_intensity( uint8_t led, uint8_t intensity );
-  /* @brief set led intensity
+  /* @brief set led intensity (shown after led_commit)
    * @param led num (0-59)
    * @param intensity (brightness) value
    * @retrn None
    */
 
+void led_set_intensity_fine( uint8_t led, uint8_t fine );
+  /* @brief set led intensity with 8-bit resolution.  Without LED_BCM
+   *   this is rounded down to a brightness level
+   * @param led num (0-59)
+   * @param fine intensity (0-LED_FINE_MAX)
+   * @retrn None
+   */
+
+void led_set_frame( const uint8_t levels[] );
+  /* @brief set the intensity of every led in one pass (shown after
+   *   led_commit)
+   * @param fine intensity (0-LED_FINE_MAX) of each led 0-59
+   * @retrn None
+   */
+
+static inline uint8_t led_level_to_fine ( uint8_t level ) {
+    return LED_LEVEL_FINE[ level > MAX_BRIGHT_VAL ? MAX_BRIGHT_VAL : level ];
+}
+  /* @brief fine intensity matching a brightness level
+   * @param brightness level
+   * @retrn fine intensity
+   */
+
 static inline void led_on ( uint8_t led, uint8_t intensity ) {
     led_set_intensity( led, intensity );
 }
@@ -101,12 +144,31 @@ void led_clear_all( void );
    * @retrn None
    */
 
+void led_commit( void );
+  /* @brief show all led changes made since the last commit.  The
+   *   new frame replaces the current one at the next frame boundary
+   * @param None
+   * @retrn None
+   */
+
 void led_set_max_brightness( uint8_t brightness);
   /* @brief set global max brightness
    * @param brightness level
    * @retrn None
    */
 
+const led_charge_stats_t * led_get_charge_stats( void );
+  /* @brief led charge estimate/limiter statistics
+   * @param None
+   * @retrn statistics
+   */
+
+void led_reset_charge_stats( void );
+  /* @brief restart the requested max and limited count statistics
+   * @param None
+   * @retrn None
+   */
+
 void _led_on_full( uint8_t led );
   /* @brief bypass pwm and turn on led via gpio
    * @param led to turn on
@@ -5,6 +5,7 @@
  *
  */
 
+#include <string.h>
 #include "asf/asf.h"
 #include "display.h"
 #include "anim.h"
@@ -14,6 +15,8 @@
 #include "aclock.h"
 #include "control.h"
 #include "utils.h"
+#include "prof.h"
+#include "trace.h"
 
 //___ M A C R O S   ( P R I V A T E ) ________________________________________
 #ifndef ABS
@@ -23,6 +26,9 @@
 #define VBATT_ADC_PIN               ADC_POSITIVE_INPUT_SCALEDIOVCC
 #define LIGHT_ADC_PIN               ADC_POSITIVE_INPUT_PIN1
 
+#define SENSOR_COUNT        2
+#define SENSOR_NONE         0xff
+
 #define DIM_BRIGHT_VAL      (MIN_BRIGHT_VAL + 1)
 #define DIM_LIGHT_THRESHOLD  17 //light level on 0-59 scale to match util display
 
@@ -44,9 +50,15 @@
       (ev_flags != EV_FLAG_NONE && \
         ev_flags != EV_FLAG_ACCEL_DOWN)
 
-#define IS_LOW_BATT(vbatt_adc_val)  ((vbatt_adc_val >> 4) < 2600) /* ~2.5v */
+/* vbatt levels, in 12-bit adc counts */
+#define VBATT_LOW_LEVEL     2600    /* ~2.5v */
+#define VBATT_DEAD_LEVEL    2300
+
+#define IS_LOW_BATT(vbatt_adc_val)  ((vbatt_adc_val >> 4) < VBATT_LOW_LEVEL)
+
+#define IS_DEAD_BATT(vbatt_adc_val) ((vbatt_adc_val >> 4) < VBATT_DEAD_LEVEL)
 
-#define IS_DEAD_BATT(vbatt_adc_val) ((vbatt_adc_val >> 4) < 2300)
+#define NEAR(a, b, margin)  ( (a) + (margin) >= (b) && (a) <= (b) + (margin) )
 
 #ifndef LOG_VBATT
 #define LOG_VBATT false
@@ -72,6 +84,31 @@
 #define ENABLE_LIGHT_SENSE true
 #endif
 
+#ifndef AUTO_BRIGHTNESS
+#define AUTO_BRIGHTNESS ENABLE_LIGHT_SENSE
+#endif
+/* Follow the ambient light with the display brightness while awake
+ * instead of choosing dim or max once at wakeup */
+
+#if (AUTO_BRIGHTNESS && !(ENABLE_LIGHT_SENSE))
+#error "AUTO_BRIGHTNESS requires ENABLE_LIGHT_SENSE"
+#endif
+
+#ifndef AUTO_BRIGHT_SAMPLE_TICKS
+#define AUTO_BRIGHT_SAMPLE_TICKS    MS_IN_TICKS(1000)
+#endif
+#ifndef AUTO_BRIGHT_SLEW_TICKS
+#define AUTO_BRIGHT_SLEW_TICKS      MS_IN_TICKS(250)
+#endif
+/* Ticks between light reads, and between brightness steps toward the
+ * level for the light */
+
+#ifndef AUTO_BRIGHT_HYSTERESIS
+#define AUTO_BRIGHT_HYSTERESIS      2
+#endif
+/* Steps of adc_light_value_scale the light must pass a level's start
+ * by to change level */
+
 #ifndef CLOCK_OUTPUT
 #define CLOCK_OUTPUT false
 #endif
@@ -92,6 +129,73 @@
 #define WAKE_GESTURES_USER_DEFAULT true
 #endif
 
+#ifndef IDLE_BETWEEN_TICKS
+#define IDLE_BETWEEN_TICKS true
+#endif
+/* Sleep (IDLE) between main loop ticks instead of polling the main timer */
+
+#ifndef VARIABLE_TICK
+#define VARIABLE_TICK IDLE_BETWEEN_TICKS
+#endif
+/* Stretch the main timer period to the next tick anything needs to run.
+ * A tick is always MS_PER_TICK long but a loop pass may cover several */
+
+#if (VARIABLE_TICK && !(IDLE_BETWEEN_TICKS))
+#error "VARIABLE_TICK requires IDLE_BETWEEN_TICKS"
+#endif
+
+#ifndef SENSOR_SHORT_SAMPLES_LOG2
+#define SENSOR_SHORT_SAMPLES_LOG2   4
+#endif
+#ifndef SENSOR_LONG_SAMPLES_LOG2
+#define SENSOR_LONG_SAMPLES_LOG2    10
+#endif
+/* Samples accumulated by a sensor read (log2).  Reads are short bursts
+ * unless the filtered value is near a decision threshold.  At least 16
+ * samples keep every read on the same 16-bit scale */
+
+#if (SENSOR_SHORT_SAMPLES_LOG2 < 4 || SENSOR_LONG_SAMPLES_LOG2 > 10)
+#error "sensor reads accumulate 16 to 1024 samples"
+#endif
+
+#ifndef SENSOR_SETTLE_SAMPLES_LOG2
+#define SENSOR_SETTLE_SAMPLES_LOG2  3
+#endif
+/* Samples thrown away (log2) before each read while the light sensor
+ * (just enabled) or the reference (just switched) settles, ~30us */
+
+#ifndef SENSOR_IIR_SHIFT
+#define SENSOR_IIR_SHIFT            2
+#endif
+/* Weight of a short read in the filtered value (1/2^n).  A read this
+ * far (12-bit counts) from the filtered value restarts it instead */
+#ifndef SENSOR_IIR_STEP
+#define SENSOR_IIR_STEP             64
+#endif
+
+#ifndef VBATT_THRESHOLD_MARGIN
+#define VBATT_THRESHOLD_MARGIN      24  /* 12-bit counts, ~1mV each */
+#endif
+#ifndef LIGHT_THRESHOLD_MARGIN
+#define LIGHT_THRESHOLD_MARGIN      2   /* steps of adc_light_value_scale */
+#endif
+
+/* Estimated supply current while reading, for the per read charge.
+ * A sample takes (1 + 12/2) cycles of the 2MHz adc clock plus
+ * 1/2 cycle sampling */
+#ifndef ADC_CURRENT_uA
+#define ADC_CURRENT_uA              1000
+#endif
+#ifndef LIGHT_SENSE_CURRENT_uA
+#define LIGHT_SENSE_CURRENT_uA      250
+#endif
+#define ADC_SAMPLE_NS               3750
+
+/* Longest main timer period.  The 16-bit 1us timer can count ~65ms */
+#define MAIN_TICK_PERIOD_MAX    MS_IN_TICKS(50)
+
+#define WDT_RESET_INTERVAL_TICKS    MS_IN_TICKS(500)
+
 //___ T Y P E D E F S   ( P R I V A T E ) ____________________________________
 typedef enum main_state_t {
   STARTUP = 0,
@@ -102,6 +206,14 @@ typedef enum main_state_t {
 
 //___ P R O T O T Y P E S   ( P R I V A T E ) ________________________________
 
+#if (IDLE_BETWEEN_TICKS)
+static void main_tc_isr( struct tc_module *const tc_inst );
+  /* @brief main timer tick interrupt
+   * @param timer instance
+   * @retrn None
+   */
+#endif  /* IDLE_BETWEEN_TICKS */
+
 #if (CLOCK_OUTPUT)
 static void setup_clock_pin_outputs( void );
   /* @brief multiplex clocks onto output pins
@@ -134,18 +246,125 @@ static void wakeup( void );
    * @retrn None
    */
 
-static void main_tic ( void );
-  /* @brief main control loop update function
+#if (ENABLE_VBATT)
+static void wake_vbatt_read_done( sensor_type_t sensor, uint16_t adc_val );
+  /* @brief log the battery voltage read at wakeup (if LOG_VBATT)
+   * @param sensor (vbatt), adc value
+   * @retrn None
+   */
+#endif  /* ENABLE_VBATT */
+
+#if (ENABLE_LIGHT_SENSE)
+static void wake_light_read_done( sensor_type_t sensor, uint16_t adc_val );
+  /* @brief pick the display brightness from the light at wakeup
+   * @param sensor (light), adc value
+   * @retrn None
+   */
+#endif  /* ENABLE_LIGHT_SENSE */
+
+#if (AUTO_BRIGHTNESS)
+static void auto_bright_light_done( sensor_type_t sensor, uint16_t adc_val );
+  /* @brief update the brightness level for a new light read
+   * @param sensor (light), adc value
+   * @retrn None
+   */
+
+static void auto_bright_tic( uint16_t ticks );
+  /* @brief read the light every AUTO_BRIGHT_SAMPLE_TICKS and step
+   *   the brightness toward its level
+   * @param ticks - # of ticks elapsed since the previous call
+   * @retrn None
+   */
+#endif  /* AUTO_BRIGHTNESS */
+
+static void configure_sensor_adc( void );
+  /* @brief configure the adc for the sensors and its result interrupt
+   * @param None
+   * @retrn None
+   */
+
+static void sensor_start_next( void );
+  /* @brief switch the adc to the next queued sensor and start it
+   *   converting.  Interrupts must be masked (or in the adc isr)
+   * @param None
+   * @retrn None
+   */
+
+static void sensor_poll( void );
+  /* @brief take the result of a finished conversion and start the
+   *   next.  Interrupts must be masked (or in the adc isr)
    * @param None
    * @retrn None
    */
 
+static void sensor_queue( sensor_type_t sensor, sensor_done_cb_t done,
+    bool long_read );
+  /* @brief queue a sensor read, starting it if the adc is idle
+   * @param sensor, callback (NULL keeps any already set),
+   *   true to accumulate SENSOR_LONG_SAMPLES_LOG2 samples
+   * @retrn None
+   */
+
+static uint16_t sensor_filter( sensor_type_t sensor, uint16_t result );
+  /* @brief add a short read to a sensor's filtered value
+   * @param sensor, 16-bit adc result
+   * @retrn new filtered value
+   */
+
+static bool sensor_near_threshold( sensor_type_t sensor, uint16_t value );
+  /* @brief check if a value is close to a level decisions are made at
+   *   (low/dead battery, dim light)
+   * @param sensor, 16-bit adc value
+   * @retrn true if a long read should settle it
+   */
+
+static void sensor_tic( void );
+  /* @brief run the callbacks of finished sensor reads
+   * @param None
+   * @retrn None
+   */
+
+static void main_tic ( uint16_t ticks );
+  /* @brief main control loop update function
+   * @param ticks - # of ticks elapsed since the previous call
+   * @retrn None
+   */
+
 static void main_init( void );
   /* @brief initialize main control module
    * @param None
    * @retrn None
    */
 
+static uint16_t wait_for_tick( void );
+  /* @brief block (idle or polling) until the next main timer tick
+   * @param None
+   * @retrn # of ticks elapsed since the previous call
+   */
+
+#if (VARIABLE_TICK)
+static uint16_t ticks_to_next_update( void );
+  /* @brief find the # of ticks until anything is next due to run
+   * @param None
+   * @retrn ticks (1 to MAIN_TICK_PERIOD_MAX)
+   */
+
+static void set_tick_period( uint16_t ticks );
+  /* @brief reprogram the main timer period
+   * @param ticks - period in ticks
+   * @retrn None
+   */
+#endif  /* VARIABLE_TICK */
+
+#if (STORE_LIFETIME_USAGE)
+static void store_pool_usage( void );
+  /* @brief merge this session's display/animation pool usage
+   *   into the stored lifetime usage data
+   * @param None
+   * @retrn None
+   */
+#endif  /* STORE_LIFETIME_USAGE */
+
 //___ V A R I A B L E S ______________________________________________________
 static struct tc_module main_tc;
 
@@ -160,7 +379,6 @@ static struct {
   uint8_t tap_count;
 
   /* sensors */
-  sensor_type_t current_sensor;
   uint16_t light_sensor_adc_val;
   uint16_t vbatt_sensor_adc_val;
 
@@ -169,6 +387,12 @@ static struct {
 
   uint8_t brightness;
 
+  /* auto brightness: level for the light, ticks since the last light
+   * read and since the last step toward the level */
+  uint8_t brightness_target;
+  uint16_t auto_bright_sample_ticks;
+  uint16_t auto_bright_slew_ticks;
+
   /* wakestamp (i.e secs since noon/midnight) of start of deep sleep wake sequence*/
   int32_t ds_wake_seq_start;
 
@@ -180,18 +404,69 @@ static struct {
   uint8_t deep_sleep_up_ctr;
 } main_gs;
 
+/* Ticks elapsed (counted by the main timer isr) and not yet
+ * handled by the main loop */
+static volatile uint16_t main_ticks_elapsed = 0;
+
+/* Current main timer period in ticks */
+static volatile uint16_t main_tick_period = 1;
+
 static animation_t *sleep_wake_anim = NULL;
 
 static struct adc_module light_vbatt_sens_adc;
 
+/* Background sensor reads.  Masks are indexed by sensor_type_t */
+static volatile uint8_t sensors_queued = 0;
+static volatile uint8_t sensors_done = 0;
+static volatile uint8_t sensor_converting = SENSOR_NONE;
+static sensor_done_cb_t sensor_done_cbs[ SENSOR_COUNT ];
+
+/* Sensors queued for a long read, and whether the current one is */
+static volatile uint8_t sensors_queued_long = 0;
+static volatile bool sensor_converting_long = false;
+static volatile bool sensor_settling = false;   // converting settle samples
+
+/* Filtered values (16-bit adc values << SENSOR_IIR_SHIFT), kept
+ * across sleeps.  0 until a sensor is first read */
+static uint32_t sensor_filtered[ SENSOR_COUNT ];
+
+static sensor_stats_t sensor_stats[ SENSOR_COUNT ];
+
+#if (AUTO_BRIGHTNESS)
+/* Start of each brightness level (from MIN_BRIGHT_VAL) on the
+ * adc_light_value_scale scale */
+static const uint8_t auto_bright_light_levels[ MAX_BRIGHT_VAL + 1 ] = {
+  0, 0, 11, DIM_LIGHT_THRESHOLD, 26, 34 };
+#endif  /* AUTO_BRIGHTNESS */
+
+/* Charge drawn so far by the read in progress (a short read that
+ * needs settling is followed by a long one) */
+static uint16_t sensor_read_charge_nC[ SENSOR_COUNT ];
+
 static uint32_t nvm_row_addr = NVM_LOG_ADDR_START;
 static uint8_t nvm_row_buffer[NVMCTRL_ROW_SIZE];
 static uint16_t nvm_row_ind;
 static struct wdt_conf config_wdt = {.enable=false};
+#if (STORE_LIFETIME_USAGE)
+/* stored pool failure counts at startup -- this session's are added */
+static uint16_t boot_disp_pool_failures;
+static uint16_t boot_anim_pool_failures;
+#endif  /* STORE_LIFETIME_USAGE */
 
 nvm_data_t main_nvm_data;
 user_data_t main_user_data;
 
+//___ I N T E R R U P T S  ___________________________________________________
+#if (IDLE_BETWEEN_TICKS)
+static void main_tc_isr( struct tc_module *const tc_inst ) {
+  main_ticks_elapsed += main_tick_period;
+}
+#endif  /* IDLE_BETWEEN_TICKS */
+
+void ADC_Handler( void ) {
+  sensor_poll();
+}
+
 //___ F U N C T I O N S   ( P R I V A T E ) __________________________________
 static void watchdog_early_warning_callback(void) {
   /* we are about to do a watchdog reset, when it wakes back up again the
@@ -269,13 +544,153 @@ static void config_main_tc( void ) {
   config_tc.counter_size = TC_COUNTER_SIZE_16BIT;
   config_tc.clock_prescaler = TC_CLOCK_PRESCALER_DIV8; //give 1us count for 8MHz clock
   config_tc.wave_generation = TC_WAVE_GENERATION_MATCH_FREQ;
-  config_tc.counter_16_bit.compare_capture_channel[0] = MAIN_TIMER_TICK_US;
+  /* the timer counts 0..CC0 so the period is CC0 + 1 */
+  config_tc.counter_16_bit.compare_capture_channel[0] = MAIN_TIMER_TICK_US - 1;
   config_tc.counter_16_bit.value = 0;
 
   tc_init(&main_tc, MAIN_TIMER, &config_tc);
+
+  /* Keep COUNT continuously synchronized so reads are current */
+  main_tc.hw->COUNT16.READREQ.reg = TC_READREQ_RCONT |
+    TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+
+  main_tick_period = 1;
+  main_ticks_elapsed = 0;
+
+#if (IDLE_BETWEEN_TICKS)
+  tc_register_callback(&main_tc, main_tc_isr, TC_CALLBACK_OVERFLOW);
+  tc_enable_callback(&main_tc, TC_CALLBACK_OVERFLOW);
+#endif  /* IDLE_BETWEEN_TICKS */
+
   tc_enable(&main_tc);
 }
 
+static uint16_t wait_for_tick( void ) {
+#if (IDLE_BETWEEN_TICKS)
+  uint16_t ticks;
+
+  /* IDLE_0 only gates the cpu clock so the led controller keeps
+   * running and its interrupts are serviced without added latency */
+  system_set_sleepmode(SYSTEM_SLEEPMODE_IDLE_0);
+
+  /* Interrupts are masked while checking the tick flag so that a
+   * tick arriving just before WFI still wakes us (a pending
+   * interrupt wakes the core even when masked) */
+  while (true) {
+    system_interrupt_disable_global();
+    if (main_ticks_elapsed) {
+      break;
+    }
+    system_sleep();
+    system_interrupt_enable_global();
+  }
+
+  ticks = main_ticks_elapsed;
+  main_ticks_elapsed = 0;
+  system_interrupt_enable_global();
+
+  return ticks;
+#else
+  while (!(tc_get_status(&main_tc) & TC_STATUS_COUNT_OVERFLOW));
+  tc_clear_status(&main_tc, TC_STATUS_COUNT_OVERFLOW);
+
+  return 1;
+#endif  /* IDLE_BETWEEN_TICKS */
+}
+
+#if (VARIABLE_TICK)
+static uint16_t ticks_to_next_update( void ) {
+  uint32_t ticks = MAIN_TICK_PERIOD_MAX;
+  uint32_t due;
+
+  if (main_gs.state == RUNNING) {
+    ticks = min(ticks, ctrl_mode_active->tick_period);
+
+    if (!(ALWAYS_ACTIVE)) {
+      /* inactivity timeout occurs once the count exceeds the timeout */
+      due = ctrl_mode_active->sleep_timeout_ticks >= main_gs.inactivity_ticks ?
+        ctrl_mode_active->sleep_timeout_ticks - main_gs.inactivity_ticks + 1 : 1;
+      ticks = min(ticks, due);
+    }
+
+#if (AUTO_BRIGHTNESS)
+    due = AUTO_BRIGHT_SAMPLE_TICKS - main_gs.auto_bright_sample_ticks;
+    ticks = min(ticks, due);
+
+    if (main_gs.brightness != main_gs.brightness_target) {
+      due = AUTO_BRIGHT_SLEW_TICKS - main_gs.auto_bright_slew_ticks;
+      ticks = min(ticks, due);
+    }
+#endif  /* AUTO_BRIGHTNESS */
+  } else if (anim_is_finished(sleep_wake_anim)) {
+    /* Sleep/wake transition is ready to advance */
+    return 1;
+  }
+
+  /* Sensor results are handed over on the next tick */
+  if (main_sensor_busy()) {
+    return 1;
+  }
+
+  ticks = min(ticks, anim_next_deadline());
+
+  /* accel events are ignored just after waking */
+  if (main_gs.waketicks <= WAKE_CLICK_IGNORE_DUR_TICKS) {
+    due = WAKE_CLICK_IGNORE_DUR_TICKS - main_gs.waketicks + 1;
+  } else {
+    due = MS_IN_TICKS(accel_ms_to_timeout());
+  }
+  ticks = min(ticks, due);
+
+  return ticks ? ticks : 1;
+}
+
+static void set_tick_period( uint16_t ticks ) {
+  uint16_t top = ticks * MAIN_TIMER_TICK_US - 1;
+  uint32_t elapsed_us;
+
+  if (ticks == main_tick_period) return;
+
+  system_interrupt_disable_global();
+
+  main_tick_period = ticks;
+  tc_set_compare_value(&main_tc, TC_COMPARE_CAPTURE_CHANNEL_0, top);
+
+  elapsed_us = tc_get_count_value(&main_tc);
+  if (elapsed_us >= top) {
+    /* The shorter period has already passed.  Credit the whole ticks
+     * that have and restart the timer from the rest, rather than
+     * letting it run through a full 16-bit rollover */
+    elapsed_us++;
+    tc_set_count_value(&main_tc, elapsed_us % MAIN_TIMER_TICK_US);
+    main_ticks_elapsed += elapsed_us / MAIN_TIMER_TICK_US;
+  }
+
+  system_interrupt_enable_global();
+}
+#endif  /* VARIABLE_TICK */
+
+#if (STORE_LIFETIME_USAGE)
+static void store_pool_usage( void ) {
+  const pool_t *disp_pool = display_get_pool();
+  const pool_t *anim_pool = anim_get_pool();
+  uint32_t failures;
+
+  if (disp_pool->high_water > main_nvm_data.disp_pool_high_water) {
+    main_nvm_data.disp_pool_high_water = disp_pool->high_water;
+  }
+  if (anim_pool->high_water > main_nvm_data.anim_pool_high_water) {
+    main_nvm_data.anim_pool_high_water = anim_pool->high_water;
+  }
+
+  /* 0xffff reads as erased flash, so saturate below it */
+  failures = boot_disp_pool_failures + disp_pool->failures;
+  main_nvm_data.disp_pool_failures = failures < 0xffff ? failures : 0xfffe;
+  failures = boot_anim_pool_failures + anim_pool->failures;
+  main_nvm_data.anim_pool_failures = failures < 0xffff ? failures : 0xfffe;
+}
+#endif  /* STORE_LIFETIME_USAGE */
+
 #if (LOG_VBATT)
 static void log_usage ( void ) {
   /* Log current vbatt with timestamp */
@@ -312,16 +727,29 @@ static void setup_clock_pin_outputs( void ) {
 
 static void prepare_sleep( void ) {
   wdt_disable();
-
-  if (light_vbatt_sens_adc.hw) {
-    adc_disable(&light_vbatt_sens_adc);
-  }
+  trace_sleep();
+
+  /* Drop unfinished sensor reads -- their callbacks never run */
+  system_interrupt_enter_critical_section();
+  sensors_queued = 0;
+  sensors_queued_long = 0;
+  sensors_done = 0;
+  sensor_converting = SENSOR_NONE;
+  sensor_settling = false;
+  memset(sensor_read_charge_nC, 0, sizeof(sensor_read_charge_nC));
+  memset(sensor_done_cbs, 0, sizeof(sensor_done_cbs));
+  adc_disable(&light_vbatt_sens_adc);
+  adc_clear_status(&light_vbatt_sens_adc, ADC_STATUS_RESULT_READY);
+  system_interrupt_leave_critical_section();
 
   port_pin_set_output_level(LIGHT_SENSE_ENABLE_PIN, false);
 
   led_controller_disable();
   aclock_disable();
   tc_disable(&main_tc);
+  main_ticks_elapsed = 0;
+
+  system_set_sleepmode(SYSTEM_SLEEPMODE_STANDBY);
 
   /* The vbatt adc may have enabled the voltage reference, so disable
    * it in standby to save power */
@@ -330,10 +758,14 @@ static void prepare_sleep( void ) {
 
 static void wakeup (void) {
   wdt_enable();
+  trace_point(TRACE_WDT);
 
   led_controller_enable();
+  trace_point(TRACE_LEDS);
   aclock_enable();
+  trace_point(TRACE_RTC);
   accel_enable();
+  trace_point(TRACE_ACCEL);
 
   /* Errata 12227: perform a software reset of tc after waking up */
   tc_reset(&main_tc);
@@ -342,40 +774,309 @@ static void wakeup (void) {
   tc_enable(&main_tc);
   system_interrupt_enable_global();
 
-  if (light_vbatt_sens_adc.hw) {
-    adc_enable(&light_vbatt_sens_adc);
-  }
+  adc_enable(&light_vbatt_sens_adc);
 
-  /* Update vbatt estimate on wakeup only */
+  /* The sensors are read in the background so the wake animation
+   * starts right away.  vbatt is updated on wakeup only */
 #if (ENABLE_VBATT)
-  main_set_current_sensor(sensor_vbatt);
-  main_start_sensor_read();
-  main_read_current_sensor(true);
+  main_sensor_read(sensor_vbatt, wake_vbatt_read_done);
 #endif  /* ENABLE_VBATT */
 
 #if (ENABLE_LIGHT_SENSE)
-  port_pin_set_output_level(LIGHT_SENSE_ENABLE_PIN, true);
-  main_set_current_sensor(sensor_light);
-  main_start_sensor_read();
+  main_sensor_read(sensor_light, wake_light_read_done);
+#endif  /* ENABLE_LIGHT_SENSE */
+
+#if (LOG_VBATT) && !(ENABLE_VBATT)
+  if (main_nvm_data.lifetime_wakes % VBATT_LOG_INTERVAL == 0) {
+    log_usage();
+  }
+#endif
 
-  main_gs.light_sensor_scaled_at_wakeup = adc_light_value_scale(
-      main_read_current_sensor(true) );
+  trace_point(TRACE_WAKEUP);
+}
 
+#if (ENABLE_VBATT)
+static void wake_vbatt_read_done( sensor_type_t sensor, uint16_t adc_val ) {
+#if (LOG_VBATT)
+  if (main_nvm_data.lifetime_wakes % VBATT_LOG_INTERVAL == 0) {
+    log_usage();
+  }
+#endif
+}
+#endif  /* ENABLE_VBATT */
+
+#if (ENABLE_LIGHT_SENSE)
+static void wake_light_read_done( sensor_type_t sensor, uint16_t adc_val ) {
+  main_gs.light_sensor_scaled_at_wakeup = adc_light_value_scale( adc_val );
+
+#if (AUTO_BRIGHTNESS)
+  /* The display is just coming on, so go straight to the level */
+  auto_bright_light_done(sensor, adc_val);
+  main_gs.brightness = main_gs.brightness_target;
+  main_gs.auto_bright_sample_ticks = 0;
+  main_gs.auto_bright_slew_ticks = 0;
+#else
   if (main_gs.light_sensor_scaled_at_wakeup < DIM_LIGHT_THRESHOLD ) {
     main_gs.brightness = DIM_BRIGHT_VAL;
   } else {
     main_gs.brightness = MAX_BRIGHT_VAL;
   }
+#endif  /* AUTO_BRIGHTNESS */
 
+  /* show it now -- a static face may not redraw for a minute */
   led_set_max_brightness( main_gs.brightness );
-  port_pin_set_output_level(LIGHT_SENSE_ENABLE_PIN, false);
+  led_commit();
+}
 #endif  /* ENABLE_LIGHT_SENSE */
 
-#if (LOG_VBATT)
-  if (main_nvm_data.lifetime_wakes % VBATT_LOG_INTERVAL == 0) {
-    log_usage();
+#if (AUTO_BRIGHTNESS)
+static void auto_bright_light_done( sensor_type_t sensor, uint16_t adc_val ) {
+  uint8_t light = adc_light_value_scale( adc_val );
+  uint8_t level = main_gs.brightness_target;
+
+  /* Leave the current level only once the light is clearly past
+   * its bounds, so a light near a boundary doesn't flicker */
+  while (level < MAX_BRIGHT_VAL && light >=
+      auto_bright_light_levels[level + 1] + AUTO_BRIGHT_HYSTERESIS) {
+    level++;
+  }
+
+  while (level > MIN_BRIGHT_VAL && light + AUTO_BRIGHT_HYSTERESIS <
+      auto_bright_light_levels[level]) {
+    level--;
+  }
+
+  main_gs.brightness_target = level;
+}
+
+static void auto_bright_tic( uint16_t ticks ) {
+  main_gs.auto_bright_sample_ticks += ticks;
+  if (main_gs.auto_bright_sample_ticks >= AUTO_BRIGHT_SAMPLE_TICKS) {
+    main_gs.auto_bright_sample_ticks = 0;
+    main_sensor_read(sensor_light, auto_bright_light_done);
+  }
+
+  if (main_gs.brightness == main_gs.brightness_target) {
+    main_gs.auto_bright_slew_ticks = 0;
+    return;
+  }
+
+  /* Step gradually so changes in brightness are not jarring */
+  main_gs.auto_bright_slew_ticks += ticks;
+  if (main_gs.auto_bright_slew_ticks >= AUTO_BRIGHT_SLEW_TICKS) {
+    main_gs.auto_bright_slew_ticks = 0;
+    main_gs.brightness += main_gs.brightness < main_gs.brightness_target ?
+      1 : -1;
+    led_set_max_brightness( main_gs.brightness );
+    led_commit();
+  }
+}
+#endif  /* AUTO_BRIGHTNESS */
+
+static void configure_sensor_adc( void ) {
+  struct adc_config config_adc;
+
+  adc_get_config_defaults(&config_adc);
+
+  /* Accumulate samples to produce each value.  The # of samples is
+   * set by each read.  From 16 samples up the 16-bit result is
+   * shifted to fit, so it is always 16x the 12-bit average */
+  config_adc.resolution         = ADC_RESOLUTION_CUSTOM;
+  config_adc.accumulate_samples = ADC_ACCUMULATE_SAMPLES_16;
+  config_adc.divide_result      = ADC_DIVIDE_RESULT_DISABLE;
+  config_adc.run_in_standby     = false;
+
+  /* Each read selects its sensor's reference and input */
+  config_adc.reference = ADC_REFERENCE_INTVCC0;
+  config_adc.positive_input = LIGHT_ADC_PIN;
+
+  adc_init(&light_vbatt_sens_adc, ADC, &config_adc);
+
+  /* Results are taken by ADC_Handler (the adc callback driver,
+   * ADC_CALLBACK_MODE, is not used) */
+  light_vbatt_sens_adc.hw->INTENSET.reg = ADC_INTENSET_RESRDY;
+  system_interrupt_enable(SYSTEM_INTERRUPT_MODULE_ADC);
+  adc_enable(&light_vbatt_sens_adc);
+}
+
+static void sensor_start_next( void ) {
+  Adc *const adc = light_vbatt_sens_adc.hw;
+  enum adc_reference reference;
+  enum adc_positive_input input;
+  uint8_t sensor;
+
+  if (!sensors_queued) return;
+
+  sensor = sensors_queued & (1 << sensor_vbatt) ? sensor_vbatt : sensor_light;
+  sensors_queued &= ~(1 << sensor);
+  sensor_converting = sensor;
+  sensor_converting_long = sensors_queued_long & (1 << sensor);
+  sensors_queued_long &= ~(1 << sensor);
+
+  if (sensor == sensor_vbatt) {
+    /* The bandgap is turned off in standby */
+    system_voltage_reference_enable(SYSTEM_VOLTAGE_REFERENCE_BANDGAP);
+    reference = ADC_REFERENCE_INT1V;
+    input = VBATT_ADC_PIN;
+  } else {
+    /* The sensor draws a lot of current, so it is only
+     * enabled while converting */
+    port_pin_set_output_level(LIGHT_SENSE_ENABLE_PIN, true);
+    reference = ADC_REFERENCE_INTVCC0;
+    input = LIGHT_ADC_PIN;
+  }
+
+  /* REFCTRL is not synchronized, so the reference can change with the
+   * adc enabled.  A settle burst is converted and thrown away first
+   * (see sensor_poll) */
+  adc->REFCTRL.reg = (adc->REFCTRL.reg & ~ADC_REFCTRL_REFSEL_Msk) | reference;
+  adc->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM( SENSOR_SETTLE_SAMPLES_LOG2 );
+  sensor_settling = true;
+  adc_set_positive_input(&light_vbatt_sens_adc, input);
+  adc_start_conversion(&light_vbatt_sens_adc);
+}
+
+static void sensor_poll( void ) {
+  sensor_stats_t *stats;
+  uint8_t sensor = sensor_converting;
+  uint16_t samples, charge_nC;
+  uint16_t result;
+
+  if (sensor == SENSOR_NONE ||
+      adc_read(&light_vbatt_sens_adc, &result) != STATUS_OK) {
+    return;
+  }
+
+  adc_clear_status(&light_vbatt_sens_adc, ADC_STATUS_RESULT_READY);
+
+  /* Account the charge the conversion drew */
+  samples = 1 << (sensor_settling ? SENSOR_SETTLE_SAMPLES_LOG2 :
+      sensor_converting_long ? SENSOR_LONG_SAMPLES_LOG2 :
+      SENSOR_SHORT_SAMPLES_LOG2);
+  charge_nC = ((uint32_t) samples * ADC_SAMPLE_NS / 1000) *
+    (ADC_CURRENT_uA + (sensor == sensor_light ? LIGHT_SENSE_CURRENT_uA : 0))
+    / 1000;
+
+  stats = &sensor_stats[sensor];
+  stats->samples += samples;
+  stats->charge_nC += charge_nC;
+  sensor_read_charge_nC[sensor] += charge_nC;
+
+  if (sensor_settling) {
+    /* Throw the settle burst away and start the read itself */
+    sensor_settling = false;
+    light_vbatt_sens_adc.hw->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM(
+        sensor_converting_long ? SENSOR_LONG_SAMPLES_LOG2 :
+        SENSOR_SHORT_SAMPLES_LOG2 );
+    adc_start_conversion(&light_vbatt_sens_adc);
+    return;
+  }
+
+  if (sensor == sensor_light) {
+    port_pin_set_output_level(LIGHT_SENSE_ENABLE_PIN, false);
+  }
+
+  stats->conversions++;
+
+  if (sensor_converting_long) {
+    sensor_filtered[sensor] = (uint32_t) result << SENSOR_IIR_SHIFT;
+    stats->long_conversions++;
+  } else {
+    result = sensor_filter(sensor, result);
+
+    if (sensor_near_threshold(sensor, result)) {
+      /* Settle it with a long read before reporting */
+      sensors_queued |= 1 << sensor;
+      sensors_queued_long |= 1 << sensor;
+      sensor_converting = SENSOR_NONE;
+      sensor_start_next();
+      return;
+    }
+  }
+
+  if (sensor == sensor_vbatt) {
+    main_gs.vbatt_sensor_adc_val = result;
+  } else {
+    main_gs.light_sensor_adc_val = result;
+  }
+
+  stats->last_read_charge_nC = sensor_read_charge_nC[sensor];
+  sensor_read_charge_nC[sensor] = 0;
+
+  sensors_done |= 1 << sensor;
+  sensor_converting = SENSOR_NONE;
+  sensor_start_next();
+}
+
+static void sensor_queue( sensor_type_t sensor, sensor_done_cb_t done,
+    bool long_read ) {
+  system_interrupt_enter_critical_section();
+
+  if (done) {
+    sensor_done_cbs[sensor] = done;
+  }
+
+  if (sensor_converting != sensor) {
+    sensors_queued |= 1 << sensor;
+    if (long_read) {
+      sensors_queued_long |= 1 << sensor;
+    }
+
+    if (sensor_converting == SENSOR_NONE) {
+      sensor_start_next();
+    }
+  }
+
+  system_interrupt_leave_critical_section();
+}
+
+static uint16_t sensor_filter( sensor_type_t sensor, uint16_t result ) {
+  uint32_t sample = (uint32_t) result << SENSOR_IIR_SHIFT;
+  uint32_t *filtered = &sensor_filtered[sensor];
+
+  /* Restart on the first read and after a step (e.g. the
+   * watch left a dark pocket) rather than lag behind */
+  if (!*filtered || !NEAR(sample >> (SENSOR_IIR_SHIFT + 4),
+        *filtered >> (SENSOR_IIR_SHIFT + 4), SENSOR_IIR_STEP)) {
+    *filtered = sample;
+  } else {
+    /* y += (x - y) / 2^n, kept as y << n */
+    *filtered = *filtered - (*filtered >> SENSOR_IIR_SHIFT) + result;
+  }
+
+  return *filtered >> SENSOR_IIR_SHIFT;
+}
+
+static bool sensor_near_threshold( sensor_type_t sensor, uint16_t value ) {
+  if (sensor == sensor_vbatt) {
+    return NEAR(value >> 4, VBATT_LOW_LEVEL, VBATT_THRESHOLD_MARGIN) ||
+      NEAR(value >> 4, VBATT_DEAD_LEVEL, VBATT_THRESHOLD_MARGIN);
+  }
+
+  return NEAR(adc_light_value_scale(value), DIM_LIGHT_THRESHOLD,
+      LIGHT_THRESHOLD_MARGIN);
+}
+
+static void sensor_tic( void ) {
+  sensor_done_cb_t done;
+  uint8_t sensor;
+
+  for (sensor = 0; sensor < SENSOR_COUNT; sensor++) {
+    system_interrupt_enter_critical_section();
+    if (!(sensors_done & (1 << sensor))) {
+      system_interrupt_leave_critical_section();
+      continue;
+    }
+    sensors_done &= ~(1 << sensor);
+    done = sensor_done_cbs[sensor];
+    sensor_done_cbs[sensor] = NULL;
+    system_interrupt_leave_critical_section();
+
+    if (done) {
+      done(sensor, sensor == sensor_vbatt ?
+          main_gs.vbatt_sensor_adc_val : main_gs.light_sensor_adc_val);
+    }
   }
-#endif
 }
 
 static int32_t get_wakestamp( void ) {
@@ -407,6 +1108,8 @@ static bool wakeup_check( void ) {
   int32_t curr_wakestamp;
   bool wake = false;
 
+  trace_point(TRACE_WAKE_CHECK);
+
 #if (USE_WAKEUP_ALARM)
     accel_wakeup_check();
     return true;
@@ -482,23 +1185,28 @@ static bool wakeup_check( void ) {
 }
 
 //___ F U N C T I O N S ______________________________________________________
-static void main_tic( void ) {
+static void main_tic( uint16_t ticks ) {
   event_flags_t event_flags = EV_FLAG_NONE;
+  uint32_t stamp;
 
-  main_gs.inactivity_ticks++;
-  main_gs.waketicks++;
+  main_gs.inactivity_ticks += ticks;
+  main_gs.waketicks += ticks;
 
   /* Get accel events flags only if enough time has passed since waking */
   if (main_gs.waketicks > WAKE_CLICK_IGNORE_DUR_TICKS) {
+    stamp = prof_stamp();
     event_flags |= accel_event_flags();
+    prof_record(PROF_ACCEL_EVENTS, stamp);
   }
 
   /* Reset inactivity if any button/click event occurs */
   if (IS_ACTIVITY_EVENT(event_flags)) {
      main_gs.inactivity_ticks = 0;
+#if !(AUTO_BRIGHTNESS)
     /* Ensure the display is not dim */
     main_gs.brightness = MAX_BRIGHT_VAL;
     led_set_max_brightness( main_gs.brightness );
+#endif  /* !AUTO_BRIGHTNESS */
   }
 
   /* ### DEBUG led controller */
@@ -534,6 +1242,7 @@ static void main_tic( void ) {
         main_nvm_data.lifetime_wakes++;
         main_nvm_data.lifetime_ticks+=main_gs.waketicks;
         if (main_nvm_data.lifetime_wakes % LIFETIME_USAGE_PERIOD == 1) {
+          store_pool_usage();
           /* Only update buffer once every 100 wakes to extend
            * lifetime of the NVM -- may fail after 100k writes */
           nvm_update_buffer(NVM_DATA_ADDR, (uint8_t *) &main_nvm_data, 0,
@@ -562,6 +1271,7 @@ static void main_tic( void ) {
         }
 
         led_clear_all();
+        display_refresh();
 
 #if 0
         if (IS_LOW_BATT(main_gs.vbatt_sensor_adc_val)) {
@@ -615,8 +1325,12 @@ static void main_tic( void ) {
           return;
       }
 
+#if (AUTO_BRIGHTNESS)
+      auto_bright_tic(ticks);
+#endif  /* AUTO_BRIGHTNESS */
+
       /* Call mode's main tic loop/event handler */
-      control_tic(event_flags);
+      control_tic(event_flags, ticks);
       return; /* END OF RUNNING STATE SWITCH CASE */
   }
 }
@@ -628,6 +1342,9 @@ static void main_init( void ) {
   main_gs.inactivity_ticks = 0;
   main_gs.light_sensor_scaled_at_wakeup = 0;
   main_gs.brightness = MAX_BRIGHT_VAL;
+  main_gs.brightness_target = MAX_BRIGHT_VAL;
+  main_gs.auto_bright_sample_ticks = 0;
+  main_gs.auto_bright_slew_ticks = 0;
   main_gs.state = STARTUP;
   main_gs.deep_sleep_mode = false;
   main_user_data.wake_gestures = WAKE_GESTURES_USER_DEFAULT;
@@ -636,6 +1353,8 @@ static void main_init( void ) {
   /* Configure main timer counter */
   config_main_tc();
 
+  configure_sensor_adc();
+
   /* Initialize NVM controller for data storage */
   struct nvm_config config_nvm;
   nvm_get_config_defaults(&config_nvm);
@@ -685,14 +1404,32 @@ static void main_init( void ) {
       main_nvm_data.wdt_resets = 0;
   }
 
+  if (main_nvm_data.disp_pool_high_water == 0xff) {
+      main_nvm_data.disp_pool_high_water = 0;
+  }
+
+  if (main_nvm_data.anim_pool_high_water == 0xff) {
+      main_nvm_data.anim_pool_high_water = 0;
+  }
+
+  if (main_nvm_data.disp_pool_failures == 0xffff) {
+      main_nvm_data.disp_pool_failures = 0;
+  }
+
+  if (main_nvm_data.anim_pool_failures == 0xffff) {
+      main_nvm_data.anim_pool_failures = 0;
+  }
+
+#if (STORE_LIFETIME_USAGE)
+  boot_disp_pool_failures = main_nvm_data.disp_pool_failures;
+  boot_anim_pool_failures = main_nvm_data.anim_pool_failures;
+#endif  /* STORE_LIFETIME_USAGE */
+
   enum system_reset_cause reset_cause = system_get_reset_cause();
   if (reset_cause == SYSTEM_RESET_CAUSE_WDT) {
       main_nvm_data.wdt_resets++;
   } else if (reset_cause == SYSTEM_RESET_CAUSE_BOD12 || reset_cause == SYSTEM_RESET_CAUSE_BOD33) {
-    do {
-      main_set_current_sensor(sensor_vbatt);
-      main_start_sensor_read();
-    } while( IS_DEAD_BATT(main_read_current_sensor(true)) );
+    while( IS_DEAD_BATT(main_sensor_read_blocking(sensor_vbatt)) );
   }
 
   nvm_update_buffer(NVM_DATA_ADDR, (uint8_t *) &main_nvm_data, 0,
@@ -746,6 +1483,7 @@ void main_terminate_in_error ( error_group_code_t error_group, uint32_t subcode
       led_on( (i + 36) % 60, BRIGHT_DEFAULT );
     }
   }
+  led_commit();
 
   if( !config_wdt.enable ) {
     configure_wdt();
@@ -755,8 +1493,10 @@ void main_terminate_in_error ( error_group_code_t error_group, uint32_t subcode
   while( 1 ) {
     //_led_on_full( ((uint8_t) error_group));
     led_on( (uint8_t) error_group, BRIGHT_DEFAULT);
+    led_commit();
     delay_ms(100);
     led_off( (uint8_t) error_group);
+    led_commit();
     delay_ms(100);
   }
 }
@@ -802,73 +1542,42 @@ void main_log_data( uint8_t *data, uint16_t length, bool flush) {
   }
 }
 
-void main_start_sensor_read ( void ) {
-  if (!(adc_get_status(&light_vbatt_sens_adc) & ADC_STATUS_RESULT_READY))
-    adc_start_conversion(&light_vbatt_sens_adc);
-}
-
-sensor_type_t main_get_current_sensor ( void ) {
-  return main_gs.current_sensor;
-}
-
-void main_set_current_sensor ( sensor_type_t sensor ) {
-  struct adc_config config_adc;
-
-  main_gs.current_sensor = sensor;
-
-  if (light_vbatt_sens_adc.hw)
-    adc_reset(&light_vbatt_sens_adc);
-
-  adc_get_config_defaults(&config_adc);
-
-  /* Average samples to produce each value */
-  config_adc.resolution         = ADC_RESOLUTION_CUSTOM;
-  config_adc.accumulate_samples = ADC_ACCUMULATE_SAMPLES_1024;
-  config_adc.divide_result      = ADC_DIVIDE_RESULT_16;
-  config_adc.run_in_standby     = false;
-  config_adc.resolution         = ADC_RESOLUTION_16BIT;
-
-  switch(sensor) {
-    case sensor_vbatt:
-      config_adc.reference = ADC_REFERENCE_INT1V;
-      config_adc.positive_input = VBATT_ADC_PIN;
-      break;
-    case sensor_light:
-      config_adc.reference = ADC_REFERENCE_INTVCC0;
-      config_adc.positive_input = LIGHT_ADC_PIN;
-      break;
-  }
-
-  adc_init(&light_vbatt_sens_adc, ADC, &config_adc);
-  adc_enable(&light_vbatt_sens_adc);
+void main_sensor_read( sensor_type_t sensor, sensor_done_cb_t done ) {
+  sensor_queue(sensor, done, false);
 }
 
-uint16_t main_read_current_sensor( bool blocking ) {
-  uint16_t result;
-  uint16_t *curr_sens_adc_val_ptr;
-  uint8_t status;
+uint16_t main_sensor_read_blocking( sensor_type_t sensor ) {
+  bool busy;
 
-  /* Read the current sensor adc (vbatt or light) */
-  /* NOTE: if reading light sensor, LIGHT_ENABLE_PIN
-   * should have already been set high for a valid read.
-   * That pin should not be left high since it draws a
-   * lot of current */
+  /* Queued reads finish first, then a fresh one is taken.  Results
+   * are polled so that this works with interrupts disabled */
+  do {
+    system_interrupt_enter_critical_section();
+    sensor_poll();
+    busy = sensor_converting != SENSOR_NONE;
+    system_interrupt_leave_critical_section();
+  } while (busy);
 
-  if (main_gs.current_sensor == sensor_vbatt)
-    curr_sens_adc_val_ptr = &main_gs.vbatt_sensor_adc_val;
-  else
-    curr_sens_adc_val_ptr = &main_gs.light_sensor_adc_val;
+  /* Always a long read -- decisions are made on the result */
+  sensor_queue(sensor, NULL, true);
 
   do {
-    status = adc_read(&light_vbatt_sens_adc, &result);
+    system_interrupt_enter_critical_section();
+    sensor_poll();
+    busy = sensor_converting != SENSOR_NONE;
+    system_interrupt_leave_critical_section();
+  } while (busy);
+
+  return sensor == sensor_vbatt ?
+    main_gs.vbatt_sensor_adc_val : main_gs.light_sensor_adc_val;
+}
 
-    if (status == STATUS_OK) {
-      *curr_sens_adc_val_ptr = result;
-      adc_clear_status(&light_vbatt_sens_adc, ADC_STATUS_RESULT_READY);
-    }
-  } while (blocking && status != STATUS_OK);
+const sensor_stats_t * main_get_sensor_stats( sensor_type_t sensor ) {
+  return &sensor_stats[sensor];
+}
 
-  return *curr_sens_adc_val_ptr;
+bool main_sensor_busy( void ) {
+  return sensors_queued || sensors_done || sensor_converting != SENSOR_NONE;
 }
 
 uint16_t main_get_light_sensor_value ( void ) {
@@ -916,10 +1625,16 @@ uint8_t main_get_multipress_count( void ) {
 
 #if !(RTC_CALIBRATE)
 int main (void) {
+  uint16_t ticks;
+  uint16_t wdt_ticks = 0;
+  uint32_t loop_stamp, stamp;
+
   system_init();
   system_set_sleepmode(SYSTEM_SLEEPMODE_STANDBY);
 
   delay_init();
+  prof_init();
+  trace_init();
   main_init();
   led_controller_init();
   led_controller_enable();
@@ -938,9 +1653,7 @@ int main (void) {
 
   /* Read vbatt sensor on startup */
 #if (ENABLE_VBATT)
-  main_set_current_sensor(sensor_vbatt);
-  main_start_sensor_read();
-  main_read_current_sensor(true);
+  main_sensor_read_blocking(sensor_vbatt);
 #endif
 
   configure_wdt();
@@ -972,16 +1685,30 @@ int main (void) {
   wdt_enable();
 
   while (1) {
-    if (tc_get_status(&main_tc) & TC_STATUS_COUNT_OVERFLOW) {
-      tc_clear_status(&main_tc, TC_STATUS_COUNT_OVERFLOW);
-      main_tic();
-      anim_tic();
-      display_tic();
-
-      if (main_gs.waketicks % 500 == 0) {
-        wdt_reset_count();
-      }
-
+    ticks = wait_for_tick();
+
+    /* Animations are advanced first so that any created by
+     * this pass are not credited with already elapsed ticks */
+    loop_stamp = prof_loop_start();
+    anim_tic(ticks);
+    prof_record(PROF_ANIM_TIC, loop_stamp);
+    sensor_tic();
+    stamp = prof_stamp();
+    main_tic(ticks);
+    stamp = prof_record(PROF_MAIN_TIC, stamp);
+    display_tic();
+    prof_record(PROF_DISPLAY_TIC, stamp);
+    trace_point(TRACE_DISPLAY);
+    prof_record(PROF_LOOP, loop_stamp);
+
+#if (VARIABLE_TICK)
+    set_tick_period(ticks_to_next_update());
+#endif  /* VARIABLE_TICK */
+
+    wdt_ticks += ticks;
+    if (wdt_ticks >= WDT_RESET_INTERVAL_TICKS) {
+      wdt_ticks = 0;
+      wdt_reset_count();
     }
   }
 }
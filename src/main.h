@@ -59,6 +59,18 @@ typedef enum sensor_type_t {
     sensor_light,
 } sensor_type_t;
 
+typedef void (*sensor_done_cb_t)( sensor_type_t sensor, uint16_t adc_val );
+
+typedef struct {
+    /* adc use by a sensor since startup.  Charge is estimated from
+     * the # of samples converted and typical supply currents */
+    uint16_t conversions;
+    uint16_t long_conversions;      /* escalated near a threshold */
+    uint32_t samples;
+    uint32_t charge_nC;
+    uint16_t last_read_charge_nC;   /* of the most recent read */
+} sensor_stats_t;
+
 typedef struct {
     /* configuration data and usage stats stored in flash
      * If updating this struct, ensure size does not
@@ -78,6 +90,10 @@ typedef struct {
     uint8_t  month;
     uint16_t year;
     bool     pm;
+    uint8_t  disp_pool_high_water;
+    uint8_t  anim_pool_high_water;
+    uint16_t disp_pool_failures;
+    uint16_t anim_pool_failures;
 
 } nvm_data_t;
 
@@ -98,29 +114,36 @@ void main_terminate_in_error( error_group_code_t error_group, uint32_t subcode )
    * @retrn None
    */
 
-void main_start_sensor_read ( void );
-  /* @brief start an adc read of current sensor
-   * @param None
+void main_sensor_read( sensor_type_t sensor, sensor_done_cb_t done );
+  /* @brief start a background adc read of a sensor.  Reads are queued
+   * and converted one at a time from the adc interrupt (vbatt first).
+   * A read is a short burst added to the sensor's filtered value,
+   * followed by a long one if that is near a decision threshold.
+   * The light sensor enable pin is driven only while it converts
+   * @param sensor to read
+   * @param done - called from the main loop with the new value
+   *   (NULL for none).  A sensor already queued keeps a single read
    * @retrn None
    */
 
-sensor_type_t main_get_current_sensor ( void );
-  /* @brief get current sensor setting
-   * @param None
-   * @retrn None
+uint16_t main_sensor_read_blocking( sensor_type_t sensor );
+  /* @brief read a sensor, waiting for any queued reads and then the
+   * new value.  Works with interrupts disabled (e.g. at startup)
+   * @param sensor to read
+   * @retrn adc value of the sensor
    */
 
-void main_set_current_sensor ( sensor_type_t sensor);
-  /* @brief set sensor to read adc values from
-   * @param None
-   * @retrn None
+const sensor_stats_t * main_get_sensor_stats( sensor_type_t sensor );
+  /* @brief get adc usage and estimated charge of a sensor's reads
+   * @param sensor
+   * @retrn usage stats
    */
 
-uint16_t main_read_current_sensor( bool blocking );
-  /* @brief read adc for most recently started sensor read
-   * the current sensor is based on the most recent sensor_read() call
-   * @param blocking - dont use cached value -- blocks until new value
-   * @retrn adc value for the current sensor
+bool main_sensor_busy( void );
+  /* @brief check for sensor reads that are queued, converting or
+   * whose callbacks have not run yet
+   * @param None
+   * @retrn true if any are outstanding
    */
 
 uint16_t main_get_light_sensor_value ( void );
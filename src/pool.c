@@ -0,0 +1,109 @@
+/** file:       pool.c
+  * created:    2026-10-16 14:02:11
+  */
+
+//___ I N C L U D E S ________________________________________________________
+#include "pool.h"
+
+//___ M A C R O S   ( P R I V A T E ) ________________________________________
+
+//___ T Y P E D E F S   ( P R I V A T E ) ____________________________________
+
+//___ P R O T O T Y P E S   ( P R I V A T E ) ________________________________
+
+//___ V A R I A B L E S ______________________________________________________
+
+//___ I N T E R R U P T S  ___________________________________________________
+
+//___ F U N C T I O N S   ( P R I V A T E ) __________________________________
+
+//___ F U N C T I O N S ______________________________________________________
+
+uint8_t pool_alloc( pool_t *pool ) {
+  uint8_t index;
+
+  if (pool->free_list != POOL_NONE) {
+    index = pool->free_list;
+    pool->free_list = POOL_NEXT(pool, index);
+  } else if (pool->fresh < pool->capacity) {
+    index = pool->fresh++;
+  } else {
+    if (pool->failures < UINT16_MAX) pool->failures++;
+    return POOL_NONE;
+  }
+
+  pool->used++;
+  if (pool->used > pool->high_water) {
+    pool->high_water = pool->used;
+  }
+
+  return index;
+}
+
+void pool_free( pool_t *pool, uint8_t index ) {
+  POOL_NEXT(pool, index) = pool->free_list;
+  pool->free_list = index;
+  pool->used--;
+}
+
+void pool_list_append( pool_t *pool, uint8_t *head, uint8_t index ) {
+  uint8_t tail;
+
+  POOL_NEXT(pool, index) = POOL_NONE;
+
+  if (*head == POOL_NONE) {
+    POOL_PREV(pool, index) = index;
+    *head = index;
+    return;
+  }
+
+  tail = POOL_PREV(pool, *head);
+  POOL_PREV(pool, index) = tail;
+  POOL_NEXT(pool, tail) = index;
+  POOL_PREV(pool, *head) = index;
+}
+
+void pool_list_insert( pool_t *pool, uint8_t *head, uint8_t index,
+    uint8_t before ) {
+  uint8_t prev;
+
+  if (before == POOL_NONE) {
+    pool_list_append(pool, head, index);
+    return;
+  }
+
+  prev = POOL_PREV(pool, before);
+  POOL_NEXT(pool, index) = before;
+  POOL_PREV(pool, index) = prev;
+  POOL_PREV(pool, before) = index;
+
+  if (before == *head) {
+    /* prev is the tail, whose next stays POOL_NONE */
+    *head = index;
+  } else {
+    POOL_NEXT(pool, prev) = index;
+  }
+}
+
+void pool_list_delete( pool_t *pool, uint8_t *head, uint8_t index ) {
+  uint8_t next = POOL_NEXT(pool, index);
+  uint8_t prev = POOL_PREV(pool, index);
+
+  if (index == *head) {
+    if (next != POOL_NONE) {
+      POOL_PREV(pool, next) = prev;
+    }
+    *head = next;
+    return;
+  }
+
+  POOL_NEXT(pool, prev) = next;
+  if (next != POOL_NONE) {
+    POOL_PREV(pool, next) = prev;
+  } else {
+    /* was the tail */
+    POOL_PREV(pool, *head) = prev;
+  }
+}
+
+// vim:shiftwidth=2
@@ -0,0 +1,111 @@
+/** file:       pool.h
+  * created:    2026-10-16 14:02:11
+  *
+  * fixed size object pools.  Each pool is a statically allocated array
+  * of one type whose items are referred to by 8-bit index.  Items carry
+  * uint8_t next and prev members (in that order), used for the pool's
+  * free list while an item is free and for a doubly linked list of the
+  * owner's while it is allocated.  Alloc and free take constant time and
+  * need no extra RAM.  Items that were never allocated are handed out in
+  * order before the free list is used, so a pool needs no initialization.
+  *
+  * Lists follow the utlist DL_ conventions: the head item's prev is the
+  * tail and the tail's next is POOL_NONE.
+  *
+  * Each pool tracks its high water mark and # of failed allocations so
+  * the capacities can be sized from field data.
+  */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+//___ I N C L U D E S ________________________________________________________
+#include <stdint.h>
+#include <stddef.h>
+
+//___ M A C R O S ____________________________________________________________
+
+/* No item (e.g. the end of a list, an empty list or pool) */
+#define POOL_NONE           0xff
+
+/* Statically allocate a pool of count items of a type */
+#define POOL_DECLARE( name, type, count )                             \
+  typedef char name##_check[ (sizeof(((type *) 0)->next) == 1         \
+      && offsetof(type, prev) == offsetof(type, next) + 1             \
+      && sizeof(type) <= 0xff && (count) < POOL_NONE) ? 1 : -1 ];     \
+  static type name##_items[ count ];                                  \
+  static pool_t name = {                                              \
+    .items = (uint8_t *) name##_items,                                \
+    .item_size = sizeof(type),                                        \
+    .link_offset = offsetof(type, next),                              \
+    .capacity = (count),                                              \
+    .free_list = POOL_NONE,                                           \
+  }
+
+/* Links of the item at an index */
+#define POOL_NEXT( pool, index ) \
+  ( ((uint8_t *) pool_item((pool), (index)))[ (pool)->link_offset ] )
+#define POOL_PREV( pool, index ) \
+  ( ((uint8_t *) pool_item((pool), (index)))[ (pool)->link_offset + 1 ] )
+
+//___ T Y P E D E F S ________________________________________________________
+typedef struct pool_t {
+  uint8_t *items;
+  uint8_t item_size;
+  uint8_t link_offset;      // of the next (then prev) index in an item
+  uint8_t capacity;
+  uint8_t fresh;            // # of items ever handed out
+  uint8_t free_list;        // most recently freed item
+  uint8_t used;
+  uint8_t high_water;       // most items used at once
+  uint16_t failures;        // # of allocations with the pool exhausted
+} pool_t;
+
+//___ V A R I A B L E S ______________________________________________________
+
+//___ P R O T O T Y P E S ____________________________________________________
+
+static inline void * pool_item( const pool_t *pool, uint8_t index ) {
+  return pool->items + index * pool->item_size;
+}
+  /* @brief find an item of a pool
+   * @param pool, item index
+   * @retrn the item
+   */
+
+uint8_t pool_alloc( pool_t *pool );
+  /* @brief allocate an item from a pool
+   * @param pool
+   * @retrn index of the item, or POOL_NONE (counted as a failure)
+   *   if the pool is full
+   */
+
+void pool_free( pool_t *pool, uint8_t index );
+  /* @brief return an item to its pool.  It must not be in a list
+   * @param pool, index of an item allocated from it
+   * @retrn None
+   */
+
+void pool_list_append( pool_t *pool, uint8_t *head, uint8_t index );
+  /* @brief add an item to the end of a list
+   * @param pool, list head index, index of item to add
+   * @retrn None
+   */
+
+void pool_list_insert( pool_t *pool, uint8_t *head, uint8_t index,
+    uint8_t before );
+  /* @brief add an item to a list ahead of another
+   * @param pool, list head index, index of item to add, index of item
+   *   in the list to add it before (POOL_NONE to append)
+   * @retrn None
+   */
+
+void pool_list_delete( pool_t *pool, uint8_t *head, uint8_t index );
+  /* @brief remove an item from a list
+   * @param pool, list head index, index of item in the list
+   * @retrn None
+   */
+
+#endif /* end of include guard: __POOL_H__ */
+
+// vim:shiftwidth=2
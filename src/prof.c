@@ -0,0 +1,82 @@
+/** file:       prof.c
+  * created:    2026-10-17 09:41:27
+  */
+
+//___ I N C L U D E S ________________________________________________________
+#include "prof.h"
+
+#if (PROFILE)
+#include "main.h"
+
+//___ M A C R O S   ( P R I V A T E ) ________________________________________
+
+/* Work allowed in a main loop pass */
+#define PROF_TICK_CYCLES    ( MAIN_TIMER_TICK_US * PROF_CYCLES_PER_US )
+
+//___ T Y P E D E F S   ( P R I V A T E ) ____________________________________
+
+//___ P R O T O T Y P E S   ( P R I V A T E ) ________________________________
+
+//___ V A R I A B L E S ______________________________________________________
+static hist_stats_t prof_stats[ PROF_SECTIONS ];
+static uint32_t prof_overruns = 0;
+
+//___ I N T E R R U P T S  ___________________________________________________
+
+//___ F U N C T I O N S   ( P R I V A T E ) __________________________________
+
+//___ F U N C T I O N S ______________________________________________________
+
+void prof_init( void ) {
+  hist_stats_init(prof_stats, PROF_SECTIONS);
+
+  SysTick->LOAD = PROF_SYSTICK_TOP;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+uint32_t prof_loop_start( void ) {
+  if (SysTick->LOAD != PROF_SYSTICK_TOP) {
+    SysTick->LOAD = PROF_SYSTICK_TOP;
+    SysTick->VAL = 0;
+  }
+
+  return prof_stamp();
+}
+
+uint32_t prof_record( prof_section_t section, uint32_t start ) {
+  uint32_t end = prof_stamp();
+  uint32_t cycles;
+
+  /* SysTick counts down */
+  cycles = (start - end) & PROF_SYSTICK_TOP;
+
+  hist_stats_add(&prof_stats[section], cycles);
+
+  if (section == PROF_LOOP && cycles > PROF_TICK_CYCLES) {
+    prof_overruns++;
+  }
+
+  return end;
+}
+
+const hist_stats_t * prof_get_stats( prof_section_t section ) {
+  return &prof_stats[section];
+}
+
+uint32_t prof_get_mean( prof_section_t section ) {
+  return hist_stats_mean(&prof_stats[section]);
+}
+
+uint32_t prof_get_overruns( void ) {
+  return prof_overruns;
+}
+
+void prof_log( void ) {
+  /* overruns then each section's stats */
+  hist_stats_log(0x70, &prof_overruns, 1, prof_stats, PROF_SECTIONS);
+}
+
+#endif  /* PROFILE */
+
+// vim:shiftwidth=2
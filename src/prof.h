@@ -0,0 +1,123 @@
+/** file:       prof.h
+  * created:    2026-10-17 09:41:27
+  *
+  * cycle profiler for the main loop.  A section of code is timed by
+  * taking a stamp before it and recording the section after it:
+  *
+  *   stamp = prof_stamp();
+  *   anim_tic(ticks);
+  *   stamp = prof_record(PROF_ANIM_TIC, stamp);
+  *
+  * Stamps are read from SysTick, free running at the cpu clock.  Each
+  * section keeps its min/mean/max cycles and a log2 histogram (see
+  * hist.h), and loop passes that take longer than a tick are counted
+  * as overruns.  Interrupts taken during a section are included in
+  * its time.
+  *
+  * Only built in with PROFILE (make profile=true) -- otherwise the
+  * stamps and records compile to nothing.  The ASF delay routines
+  * also use SysTick, so a section that calls delay_ms() is garbage
+  */
+
+#ifndef __PROF_H__
+#define __PROF_H__
+
+//___ I N C L U D E S ________________________________________________________
+#include <stdint.h>
+#include <stdbool.h>
+#include "hist.h"
+
+#ifndef PROFILE
+#define PROFILE false
+#endif
+
+#if (PROFILE)
+#include <asf.h>
+#endif
+
+//___ M A C R O S ____________________________________________________________
+
+/* SysTick is 24 bits, so sections must be shorter than ~2s */
+#define PROF_SYSTICK_TOP        0xffffff
+#define PROF_CYCLES_PER_US      8       /* 8MHz cpu clock */
+
+//___ T Y P E D E F S ________________________________________________________
+typedef enum prof_section_t {
+  PROF_LOOP,            // main loop pass (the sections below but led isr)
+  PROF_MAIN_TIC,
+  PROF_ANIM_TIC,
+  PROF_DISPLAY_TIC,
+  PROF_ACCEL_EVENTS,
+  PROF_LED_ISR,
+  PROF_SECTIONS
+} prof_section_t;
+
+//___ V A R I A B L E S ______________________________________________________
+
+//___ P R O T O T Y P E S ____________________________________________________
+
+#if (PROFILE)
+static inline uint32_t prof_stamp( void ) {
+  return SysTick->VAL;
+}
+  /* @brief take a cycle stamp to time a section from
+   * @param None
+   * @retrn stamp
+   */
+
+uint32_t prof_record( prof_section_t section, uint32_t start );
+  /* @brief add a run of a section to its stats
+   * @param section, stamp taken at its start
+   * @retrn stamp at its end (e.g. to start the next section)
+   */
+
+uint32_t prof_loop_start( void );
+  /* @brief take the stamp a main loop pass starts at.  Restarts
+   *   SysTick if a delay has reprogrammed it
+   * @param None
+   * @retrn stamp
+   */
+
+void prof_init( void );
+  /* @brief start SysTick free running for the profiler
+   * @param None
+   * @retrn None
+   */
+
+const hist_stats_t * prof_get_stats( prof_section_t section );
+  /* @brief get the stats of a section
+   * @param section
+   * @retrn stats since startup
+   */
+
+uint32_t prof_get_mean( prof_section_t section );
+  /* @brief get the mean cycles of a section
+   * @param section
+   * @retrn mean cycles (0 if it has not run)
+   */
+
+uint32_t prof_get_overruns( void );
+  /* @brief # of main loop passes that took longer than a tick
+   *   (MAIN_TIMER_TICK_US)
+   * @param None
+   * @retrn overrun count
+   */
+
+void prof_log( void );
+  /* @brief write a record of all the stats to the nvm log (see
+   *   scripts/stats_summary.py)
+   * @param None
+   * @retrn None
+   */
+#else
+static inline uint32_t prof_stamp( void ) { return 0; }
+static inline uint32_t prof_record( prof_section_t section, uint32_t start ) {
+  return 0;
+}
+static inline uint32_t prof_loop_start( void ) { return 0; }
+static inline void prof_init( void ) {}
+#endif  /* PROFILE */
+
+#endif /* end of include guard: __PROF_H__ */
+
+// vim:shiftwidth=2
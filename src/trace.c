@@ -0,0 +1,143 @@
+/** file:       trace.c
+  * created:    2026-10-17 14:02:51
+  */
+
+//___ I N C L U D E S ________________________________________________________
+#include "trace.h"
+
+#if (WAKE_TRACE)
+#include "main.h"
+#include "hist.h"
+
+//___ M A C R O S   ( P R I V A T E ) ________________________________________
+
+//___ T Y P E D E F S   ( P R I V A T E ) ____________________________________
+
+//___ P R O T O T Y P E S   ( P R I V A T E ) ________________________________
+
+static uint32_t trace_stamp( void );
+  /* @brief read the free running counter
+   * @param None
+   * @retrn stamp in ticks
+   */
+
+static void trace_finish( void );
+  /* @brief add the stages of a fully stamped wake to the stats
+   * @param None
+   * @retrn None
+   */
+
+//___ V A R I A B L E S ______________________________________________________
+static hist_stats_t trace_stats[ TRACE_POINTS ];
+static uint32_t trace_stamps[ TRACE_POINTS ];
+static uint16_t trace_stamped = 0;      // mask of points stamped this wake
+static bool trace_armed = false;
+
+static uint32_t trace_wakes = 0;        // # of wakes traced
+static uint32_t trace_rejects = 0;      // # of wake checks that slept again
+static uint32_t trace_skipped = 0;      // # of wakes that missed a point
+static bool trace_log_due = false;
+
+//___ I N T E R R U P T S  ___________________________________________________
+
+//___ F U N C T I O N S   ( P R I V A T E ) __________________________________
+
+static uint32_t trace_stamp( void ) {
+  uint32_t count;
+
+  /* Stamped from accel_isr as well */
+  system_interrupt_enter_critical_section();
+  while (TCC1->SYNCBUSY.reg & TCC_SYNCBUSY_CTRLB);
+  TCC1->CTRLBSET.reg = TCC_CTRLBSET_CMD_READSYNC;
+  while (TCC1->SYNCBUSY.reg & (TCC_SYNCBUSY_CTRLB | TCC_SYNCBUSY_COUNT));
+  count = TCC1->COUNT.reg;
+  system_interrupt_leave_critical_section();
+
+  return count;
+}
+
+static void trace_finish( void ) {
+  uint8_t i;
+
+  trace_armed = false;
+
+  if (trace_stamped != (1 << TRACE_POINTS) - 1) {
+    trace_skipped++;
+    return;
+  }
+
+  for (i = TRACE_ACCEL_ISR + 1; i < TRACE_POINTS; i++) {
+    hist_stats_add(&trace_stats[i],
+        (trace_stamps[i] - trace_stamps[i - 1]) & TRACE_COUNT_TOP);
+  }
+  hist_stats_add(&trace_stats[TRACE_WAKE], (trace_stamps[TRACE_DISPLAY] -
+        trace_stamps[TRACE_ACCEL_ISR]) & TRACE_COUNT_TOP);
+
+  trace_wakes++;
+  if (trace_wakes % WAKE_TRACE_LOG_WAKES == 0) {
+    trace_log_due = true;
+  }
+}
+
+//___ F U N C T I O N S ______________________________________________________
+
+void trace_point( trace_point_t point ) {
+  if (!trace_armed) return;
+
+  /* A point may be stamped by several wake checks, so keep the
+   * last (i.e. of the check that woke us) */
+  trace_stamps[point] = trace_stamp();
+  trace_stamped |= 1 << point;
+
+  if (point == TRACE_WAKE_CHECK && (trace_stamped & (1 << TRACE_ACCEL_CHECK))) {
+    /* a previous check went back to sleep */
+    trace_rejects++;
+    trace_stamped &= ~(1 << TRACE_ACCEL_CHECK);
+  }
+
+  if (point == TRACE_DISPLAY) {
+    trace_finish();
+  }
+}
+
+void trace_sleep( void ) {
+  if (trace_log_due) {
+    trace_log_due = false;
+    trace_log();
+  }
+
+  trace_stamped = 0;
+  trace_armed = true;
+}
+
+void trace_init( void ) {
+  struct system_gclk_chan_config gclk_chan_conf;
+  hist_stats_init(trace_stats, TRACE_POINTS);
+
+  system_apb_clock_set_mask(SYSTEM_CLOCK_APB_APBC, PM_APBCMASK_TCC1);
+
+  /* GCLK3 is the 32kHz crystal, run in standby with WAKE_TRACE */
+  system_gclk_chan_get_config_defaults(&gclk_chan_conf);
+  gclk_chan_conf.source_generator = GCLK_GENERATOR_3;
+  system_gclk_chan_set_config(TCC1_GCLK_ID, &gclk_chan_conf);
+  system_gclk_chan_enable(TCC1_GCLK_ID);
+
+  TCC1->CTRLA.reg = TCC_CTRLA_SWRST;
+  while (TCC1->SYNCBUSY.reg & TCC_SYNCBUSY_SWRST);
+
+  TCC1->CTRLA.reg = TCC_CTRLA_PRESCALER_DIV1 | TCC_CTRLA_RUNSTDBY;
+  TCC1->PER.reg = TRACE_COUNT_TOP;
+  TCC1->CTRLA.reg |= TCC_CTRLA_ENABLE;
+  while (TCC1->SYNCBUSY.reg & TCC_SYNCBUSY_ENABLE);
+}
+
+void trace_log( void ) {
+  /* wakes, rejected checks, skipped wakes then each stage's stats */
+  uint32_t counters[3] = { trace_wakes, trace_rejects, trace_skipped };
+
+  hist_stats_log(0x74, counters, 3, trace_stats, TRACE_POINTS);
+}
+
+#endif  /* WAKE_TRACE */
+
+// vim:shiftwidth=2
@@ -0,0 +1,112 @@
+/** file:       trace.h
+  * created:    2026-10-17 14:02:51
+  *
+  * wake latency tracer.  Each wake from standby is stamped at the
+  * trace points below, from the accelerometer interrupt to the first
+  * display_tic after wakeup():
+  *
+  *   trace_point(TRACE_WAKE_CHECK);
+  *
+  * Stamps are read from TCC1 free running at the 32kHz crystal (via
+  * GCLK3), which keeps counting in standby.  When the first display_tic
+  * is stamped the time between consecutive points is added to the
+  * stats of that stage (see hist.h), and the whole wake to the
+  * TRACE_WAKE stats.
+  * Wakes that miss a point (e.g. from deep sleep) are only counted as
+  * skipped.
+  *
+  * Each stamp waits for a COUNT read sync of ~5 ticks (~150us), which
+  * is charged to the stage it ends.
+  *
+  * Only built in with WAKE_TRACE (make wake_trace=true) -- otherwise the
+  * points compile to nothing.  Records are written to the nvm log when
+  * going to sleep every WAKE_TRACE_LOG_WAKES wakes (see
+  * scripts/stats_summary.py)
+  */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+//___ I N C L U D E S ________________________________________________________
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef WAKE_TRACE
+#define WAKE_TRACE false
+#endif
+
+#if (WAKE_TRACE)
+#include <asf.h>
+#endif
+
+//___ M A C R O S ____________________________________________________________
+
+#ifndef WAKE_TRACE_LOG_WAKES
+#define WAKE_TRACE_LOG_WAKES    100
+#endif
+
+#define TRACE_TICKS_PER_SEC     32768
+#define TRACE_COUNT_TOP         0xffffff  /* TCC1 is 24 bits (~8.5min) */
+
+#if (WAKE_TRACE) && defined(RTC_CALIBRATE) && (RTC_CALIBRATE)
+/* TCC1 shares its generic clock with TCC0 used by the calibration */
+#error "WAKE_TRACE can't be used with RTC_CALIBRATE"
+#endif
+
+//___ T Y P E D E F S ________________________________________________________
+typedef enum trace_point_t {
+  TRACE_ACCEL_ISR,      // accel_isr entry (the last one before waking)
+  TRACE_WAKE_CHECK,     // wakeup_check() entry, back from system_sleep()
+  TRACE_ACCEL_CHECK,    // accel_wakeup_check() done (fifo read, filters)
+  TRACE_WDT,            // wakeup() stages ...
+  TRACE_LEDS,
+  TRACE_RTC,            // rtc read sync wait
+  TRACE_ACCEL,
+  TRACE_WAKEUP,         // ... wakeup() done
+  TRACE_DISPLAY,        // first display_tic done
+  TRACE_POINTS
+} trace_point_t;
+
+/* The stats of a point are of the stage ending at it, except for the
+ * first point which has none -- its stats are of the whole wake */
+#define TRACE_WAKE      TRACE_ACCEL_ISR
+
+//___ V A R I A B L E S ______________________________________________________
+
+//___ P R O T O T Y P E S ____________________________________________________
+
+#if (WAKE_TRACE)
+void trace_point( trace_point_t point );
+  /* @brief stamp a trace point of the current wake.  Ignored while
+   *   awake, after the wake's first display_tic
+   * @param point
+   * @retrn None
+   */
+
+void trace_sleep( void );
+  /* @brief start tracing the next wake, first logging the stats if due
+   * @param None
+   * @retrn None
+   */
+
+void trace_init( void );
+  /* @brief start TCC1 free running for the tracer
+   * @param None
+   * @retrn None
+   */
+
+void trace_log( void );
+  /* @brief write a record of all the stats to the nvm log (see
+   *   scripts/stats_summary.py)
+   * @param None
+   * @retrn None
+   */
+#else
+static inline void trace_point( trace_point_t point ) {}
+static inline void trace_sleep( void ) {}
+static inline void trace_init( void ) {}
+#endif  /* WAKE_TRACE */
+
+#endif /* end of include guard: __TRACE_H__ */
+
+// vim:shiftwidth=2